@@ -19,7 +19,10 @@
 #include "simple16.h"
 #include "variablebyte.h"
 
+#include <array>
 #include <cassert>
+#include <cstring>
+#include <limits>
 namespace coder {
 
 struct vbyte {
@@ -164,6 +167,47 @@ struct vbyte_fastpfor {
 		}
 		is.skip(processed_ints * sizeof(uint32_t) * 8);
 	}
+	// decodes n d-gaps and adds them up while decoding, so out_buf holds
+	// the prefix sums starting from base. returns the last sum.
+	template <class t_bit_istream>
+	inline uint32_t decode_dgap(const t_bit_istream& is, uint32_t* out_buf, size_t n, uint32_t base = 0) const
+	{
+		is.align64();
+
+		size_t	to_decode		 = n;
+		uint32_t* input_ptr		 = (uint32_t*)is.cur_data8();
+		uint32_t* output_ptr	 = out_buf;
+		uint64_t  processed_ints = 0;
+		while (to_decode) {
+			size_t chunk_size					   = 1024 * 1024 * 1024;
+			if (to_decode < chunk_size) chunk_size = to_decode;
+
+			uint32_t encoded_size = *input_ptr;
+			input_ptr++;
+			processed_ints++;
+
+			// same format as FastPForLib::VByte, the last byte of a value
+			// has the high bit unset
+			const uint8_t* in8 = (const uint8_t*)input_ptr;
+			for (size_t i = 0; i < chunk_size; i++) {
+				uint32_t c = *in8++;
+				uint32_t v = c & 0x7F;
+				for (uint32_t shift = 7; c >= 128; shift += 7) {
+					c = *in8++;
+					v |= (c & 0x7F) << shift;
+				}
+				base += v;
+				output_ptr[i] = base;
+			}
+
+			output_ptr += chunk_size;
+			to_decode -= chunk_size;
+			input_ptr += encoded_size;
+			processed_ints += encoded_size;
+		}
+		is.skip(processed_ints * sizeof(uint32_t) * 8);
+		return base;
+	}
 };
 
 struct simple16 {
@@ -280,25 +324,33 @@ public:
 	static const uint32_t window_bits = 15;
 
 private:
-	mutable z_stream dstrm;
-	mutable z_stream istrm;
+	// the streams are reset after every use and shared by the zlib coders
+	// of a thread
+	struct streams {
+		z_stream dstrm;
+		z_stream istrm;
+		streams()
+		{
+			dstrm.zalloc = Z_NULL;
+			dstrm.zfree  = Z_NULL;
+			dstrm.opaque = Z_NULL;
+			deflateInit2(&dstrm, t_level, Z_DEFLATED, window_bits, mem_level, Z_DEFAULT_STRATEGY);
+			istrm.zalloc = Z_NULL;
+			istrm.zfree  = Z_NULL;
+			istrm.opaque = Z_NULL;
+			inflateInit2(&istrm, window_bits);
+		}
+		~streams()
+		{
+			deflateEnd(&dstrm);
+			inflateEnd(&istrm);
+		}
+	};
 
-public:
-	zlib()
-	{
-		dstrm.zalloc = Z_NULL;
-		dstrm.zfree  = Z_NULL;
-		dstrm.opaque = Z_NULL;
-		deflateInit2(&dstrm, t_level, Z_DEFLATED, window_bits, mem_level, Z_DEFAULT_STRATEGY);
-		istrm.zalloc = Z_NULL;
-		istrm.zfree  = Z_NULL;
-		istrm.opaque = Z_NULL;
-		inflateInit2(&istrm, window_bits);
-	}
-	~zlib()
+	static streams& thread_streams()
 	{
-		deflateEnd(&dstrm);
-		inflateEnd(&istrm);
+		static thread_local streams strms;
+		return strms;
 	}
 
 public:
@@ -321,6 +373,7 @@ public:
 
 		uint32_t out_buf_bytes = bits_required >> 3;
 
+		auto& dstrm		= thread_streams().dstrm;
 		dstrm.avail_in  = in_size;
 		dstrm.avail_out = out_buf_bytes;
 		dstrm.next_in   = (uint8_t*)in_buf;
@@ -375,6 +428,7 @@ again with Z_FINISH and more output spac */
 		auto	 in_buf   = is.cur_data8();
 		uint64_t out_size = n * sizeof(T);
 
+		auto& istrm		= thread_streams().istrm;
 		istrm.avail_in  = in_size;
 		istrm.next_in   = (uint8_t*)in_buf;
 		istrm.avail_out = out_size;
@@ -464,6 +518,59 @@ public:
 	static const int bzip_work_factor   = 0;
 	static const int bzip_use_small_mem = 0;
 
+private:
+	// every bzip2 stream allocates its tables, megabytes at the higher
+	// levels. released tables are kept per thread and handed out again to
+	// requests of the same size.
+	struct allocation_pool {
+		struct block {
+			void*  ptr;
+			size_t size;
+			bool   used;
+		};
+		std::vector<block> blocks;
+
+		~allocation_pool()
+		{
+			for (auto& b : blocks)
+				free(b.ptr);
+		}
+
+		static void* alloc(void* opaque, int items, int size)
+		{
+			auto&  pool  = *(allocation_pool*)opaque;
+			size_t bytes = size_t(items) * size_t(size);
+			for (auto& b : pool.blocks) {
+				if (!b.used && b.size == bytes) {
+					b.used = true;
+					return b.ptr;
+				}
+			}
+			void* ptr = malloc(bytes);
+			if (ptr != nullptr) pool.blocks.push_back(block{ptr, bytes, true});
+			return ptr;
+		}
+
+		static void release(void* opaque, void* ptr)
+		{
+			auto& pool = *(allocation_pool*)opaque;
+			for (auto& b : pool.blocks) {
+				if (b.ptr == ptr) b.used = false;
+			}
+		}
+	};
+
+	static bz_stream pooled_stream()
+	{
+		static thread_local allocation_pool pool;
+		bz_stream							strm;
+		memset(&strm, 0, sizeof(strm));
+		strm.bzalloc = allocation_pool::alloc;
+		strm.bzfree  = allocation_pool::release;
+		strm.opaque  = &pool;
+		return strm;
+	}
+
 public:
 	static std::string type() { return "bzip2-" + std::to_string(t_level); }
 
@@ -481,7 +588,6 @@ public:
 		char*	output_ptr			 = (char*)out_buf;
 		uint64_t total_written_bytes = 0;
 		while (in_size) {
-			uint32_t written_bytes				 = (bits_required >> 3ULL);
 			uint32_t chunk_size					 = 1024 * 1024 * 1024;
 			if (in_size < chunk_size) chunk_size = in_size;
 
@@ -489,15 +595,19 @@ public:
 			output_ptr += sizeof(uint32_t);
 			total_written_bytes += sizeof(uint32_t);
 
-			auto ret = BZ2_bzBuffToBuffCompress(output_ptr,
-												&written_bytes,
-												input_ptr,
-												chunk_size,
-												t_level,
-												bzip_verbose_level,
-												bzip_work_factor);
+			bz_stream strm = pooled_stream();
+			auto ret = BZ2_bzCompressInit(&strm, t_level, bzip_verbose_level, bzip_work_factor);
+			if (ret == BZ_OK) {
+				strm.next_in   = input_ptr;
+				strm.avail_in  = chunk_size;
+				strm.next_out  = output_ptr;
+				strm.avail_out = (bits_required >> 3) - total_written_bytes;
+				ret			   = BZ2_bzCompress(&strm, BZ_FINISH);
+			}
+			uint32_t written_bytes = strm.total_out_lo32;
+			BZ2_bzCompressEnd(&strm);
 
-			if (ret != BZ_OK) {
+			if (ret != BZ_STREAM_END) {
 				LOG(ERROR) << "n = " << chunk_size;
 				LOG(ERROR) << "bits_required = " << bits_required;
 				LOG(ERROR) << "written bytes = " << written_bytes;
@@ -525,10 +635,19 @@ public:
 			uint32_t  cur_in_size	= *cur_input_size;
 			in_buf += sizeof(uint32_t);
 			data_processed += cur_in_size + sizeof(uint32_t);
-			uint32_t out_size = 2ULL * 1024ULL * 1024ULL * 1024ULL;
-			auto	 ret	  = BZ2_bzBuffToBuffDecompress(
-			out_ptr, &out_size, in_buf, cur_in_size, bzip_use_small_mem, bzip_verbose_level);
-			if (ret != BZ_OK) {
+
+			bz_stream strm = pooled_stream();
+			auto	  ret  = BZ2_bzDecompressInit(&strm, bzip_verbose_level, bzip_use_small_mem);
+			if (ret == BZ_OK) {
+				strm.next_in   = in_buf;
+				strm.avail_in  = cur_in_size;
+				strm.next_out  = out_ptr;
+				strm.avail_out = std::min(to_recover, uint64_t(std::numeric_limits<uint32_t>::max()));
+				ret			   = BZ2_bzDecompress(&strm);
+			}
+			uint32_t out_size = strm.total_out_lo32;
+			BZ2_bzDecompressEnd(&strm);
+			if (ret != BZ_STREAM_END) {
 				LOG(FATAL) << "bzip2-decode: decode error: " << ret;
 			}
 			in_buf += cur_in_size;
@@ -623,19 +742,22 @@ public:
 	static const uint32_t lzma_max_mem_limit = 1024 * 1024 * 1024;
 
 private:
-	mutable lzma_stream strm_enc;
-	mutable lzma_stream strm_dec;
+	// re-initialized streams keep their allocations, so the streams are
+	// reused by all lzma coders of a thread
+	struct streams {
+		lzma_stream enc = LZMA_STREAM_INIT;
+		lzma_stream dec = LZMA_STREAM_INIT;
+		~streams()
+		{
+			lzma_end(&enc);
+			lzma_end(&dec);
+		}
+	};
 
-public:
-	lzma()
-	{
-		strm_enc = LZMA_STREAM_INIT;
-		strm_dec = LZMA_STREAM_INIT;
-	}
-	~lzma()
+	static streams& thread_streams()
 	{
-		lzma_end(&strm_enc);
-		lzma_end(&strm_dec);
+		static thread_local streams strms;
+		return strms;
 	}
 
 public:
@@ -653,6 +775,7 @@ public:
 		os.skip(64);
 
 		/* init compressor */
+		auto&	strm_enc  = thread_streams().enc;
 		uint64_t osize	 = bits_required >> 3;
 		uint8_t* out_buf   = os.cur_data8();
 		uint64_t in_size   = n * sizeof(T);
@@ -694,11 +817,12 @@ public:
 		uint64_t  in_size  = *pin_size;
 		is.skip(64);
 
-		/* setup decoder */
+		/* setup decoder. the data is always in the xz format */
+		auto&	strm_dec = thread_streams().dec;
 		auto	 in_buf   = is.cur_data8();
 		uint64_t out_size = n * sizeof(T);
 		int		 res;
-		if ((res = lzma_auto_decoder(&strm_dec, lzma_mem_limit, 0)) != LZMA_OK) {
+		if ((res = lzma_stream_decoder(&strm_dec, lzma_mem_limit, 0)) != LZMA_OK) {
 			LOG(FATAL) << "lzma-decode: error init LMZA decoder:" << res;
 		}
 
@@ -735,16 +859,27 @@ public:
 template <uint8_t t_level = 6>
 struct zstd {
 private:
-	ZSTD_DStream* dstream;
+	// contexts are expensive to set up and are reused by all zstd coders of
+	// a thread
+	struct contexts {
+		ZSTD_CCtx* cctx = ZSTD_createCCtx();
+		ZSTD_DCtx* dctx = ZSTD_createDCtx();
+		~contexts()
+		{
+			ZSTD_freeCCtx(cctx);
+			ZSTD_freeDCtx(dctx);
+		}
+	};
+
+	static contexts& thread_contexts()
+	{
+		static thread_local contexts ctxs;
+		return ctxs;
+	}
 
 public:
 	static std::string type() { return "zstd-" + std::to_string(t_level); }
 
-	zstd() { dstream = ZSTD_createDStream(); }
-
-	~zstd() { ZSTD_freeDStream(dstream); }
-
-
 	template <class t_bit_ostream, class T>
 	inline void encode(t_bit_ostream& os, const T* in_buf, size_t n) const
 	{
@@ -762,7 +897,8 @@ public:
 
 		uint64_t	   out_buf_bytes = bits_required >> 3;
 		const uint8_t* in			 = (uint8_t*)in_buf;
-		auto		   cSize		 = ZSTD_compress(out_buf, out_buf_bytes, in, in_size, t_level);
+		auto		   cSize		 = ZSTD_compressCCtx(
+		thread_contexts().cctx, out_buf, out_buf_bytes, in, in_size, t_level);
 
 		if (ZSTD_isError(cSize)) {
 			LOG(FATAL) << "zstd-encode: error compressing! " << ZSTD_getErrorName(cSize);
@@ -782,39 +918,19 @@ public:
 		uint64_t  in_size  = *pin_size;
 		is.skip(64);
 
-		/* decode */
+		/* decode in one go, the output size is known */
 		auto	 in_buf   = is.cur_data8();
 		uint64_t out_size = n * sizeof(T);
 		auto	 src	  = (uint8_t*)in_buf;
 		auto	 out	  = (uint8_t*)out_buf;
+		auto dSize = ZSTD_decompressDCtx(thread_contexts().dctx, out, out_size, src, in_size);
 
-		size_t const initResult = ZSTD_initDStream(dstream);
-		if (ZSTD_isError(initResult)) {
-			fprintf(stderr, "ZSTD_initDStream() error : %s \n", ZSTD_getErrorName(initResult));
-			exit(EXIT_FAILURE);
+		if (ZSTD_isError(dSize)) {
+			LOG(FATAL) << "zstd-decode: error decoding! " << ZSTD_getErrorName(dSize);
 		}
-
-		ZSTD_inBuffer input				 = {src, in_size, 0};
-		size_t		  decompressed_bytes = 0;
-		size_t		  toRead			 = initResult;
-		while (input.pos < input.size) {
-			ZSTD_outBuffer output = {out, out_size, 0};
-			/* toRead : size of next compressed block */
-			toRead = ZSTD_decompressStream(dstream, &output, &input);
-			if (ZSTD_isError(toRead)) {
-				fprintf(stderr, "ZSTD_decompressStream() error : %s \n", ZSTD_getErrorName(toRead));
-				exit(EXIT_FAILURE);
-			}
-			out += output.pos;
-			decompressed_bytes += output.pos;
+		if (dSize != out_size) {
+			LOG(FATAL) << "zstd-decode: decoded " << dSize << " bytes instead of " << out_size;
 		}
-
-
-		// auto dSize = ZSTD_decompress(out, out_size, src, in_size);
-
-		// if (decompressed_bytes != out_size) {
-		// 	LOG(FATAL) << "zstd-decode: error decoding! " << ZSTD_getErrorName(dSize);
-		// }
 		is.skip(in_size * 8); // skip over the read content
 	}
 };
@@ -916,24 +1032,6 @@ private:
 			os.put_int_no_size_check((val - 1) & 1, 1);
 		}
 	}
-	template <class t_bit_istream>
-	inline uint64_t read_center_mid(t_bit_istream& is, uint64_t u) const
-	{
-		auto	 b   = u == 1 ? 0 : sdsl::bits::hi(u - 1) + 1ULL;
-		auto	 d   = 2ULL * u - (1ULL << b);
-		uint64_t val = 1;
-		if (u != 1) {
-			uint64_t m = (1ULL << b) - u;
-			val		   = is.get_int(b - 1) + 1;
-			if (val > m) {
-				val = (2ULL * val + is.get_int(1)) - m - 1;
-			}
-		}
-		val = val + d / 2;
-		if (val > u) val -= u;
-		return val;
-	}
-
 	template <class t_bit_ostream, class T>
 	inline void
 	encode_interpolative(t_bit_ostream& os, T* in_buf, size_t n, size_t low, size_t high) const
@@ -948,18 +1046,100 @@ private:
 		encode_interpolative(os, in_buf + h, n2, v + 1, high);
 	}
 
-	template <class t_bit_istream, class T>
-	inline void
-	decode_interpolative(t_bit_istream& is, T* out_buf, size_t n, size_t low, size_t high) const
+	// a subtree still to be decoded: n values at out_buf[offset,offset+n),
+	// all in [low-1,high-1]
+	struct pending_range {
+		size_t   offset;
+		size_t   n;
+		uint64_t low;
+		uint64_t high;
+	};
+
+	// reads the centered minimal binary code of a value in [1,r], r > 1.
+	// both parts of the code are fetched with one load.
+	static uint64_t read_center_mid(const uint64_t* data, uint64_t& pos, uint64_t safe_end, uint64_t size, uint64_t r)
 	{
+		uint64_t b = sdsl::bits::hi(r - 1) + 1ULL;
+		uint64_t m = (1ULL << b) - r;
+		uint64_t x;
+		if (pos <= safe_end) {
+			memcpy(&x, (const uint8_t*)data + (pos >> 3), sizeof(x));
+			x >>= pos & 7;
+		} else {
+			// at most b-1 bits are left if the code is the short one
+			x = sdsl::bits::read_int(data + (pos >> 6), pos & 0x3F, std::min(b, size - pos));
+		}
+		// long and short codes are equally likely, so no branches
+		uint64_t val	  = (x & sdsl::bits::lo_set[b - 1]) + 1;
+		uint64_t is_long  = val > m;
+		uint64_t long_val = 2ULL * val + ((x >> (b - 1)) & 1) - m - 1;
+		val				  = is_long ? long_val : val;
+		pos += b - 1 + is_long;
+		val += r - (1ULL << (b - 1));
+		val -= val > r ? r : 0;
+		return val;
+	}
+
+	// iterative version of the recursive pre-order walk of the encoder. left
+	// subtrees are descended into directly while the right ones wait on the
+	// stack, so it never holds more than one range per level. a range that
+	// fills its universe (high - low + 1 == n) was encoded with zero bits and
+	// is written out directly. with t_range set decoding stops at the first
+	// range above hi and [first,last) receives the positions of the values
+	// in [lo,hi].
+	template <bool t_range, class t_bit_istream, class T>
+	inline void decode_iterative(const t_bit_istream& is, T* out_buf, size_t n, uint64_t u,
+	uint64_t lo, uint64_t hi, size_t& first, size_t& last) const
+	{
+		const uint64_t* data	 = is.data();
+		const uint64_t  size	 = is.size();
+		const uint64_t  safe_end = ((size + 63) / 64) * 64 < 64 ? 0 : ((size + 63) / 64) * 64 - 64;
+		uint64_t		pos		 = is.tellg();
+		first					 = n;
+		last					 = 0;
 		if (n == 0) return;
-		size_t   h	 = (n + 1) >> 1;
-		size_t   n1	= h - 1;
-		size_t   n2	= n - h;
-		uint64_t v	 = low + n1 - 1 + read_center_mid(is, high - n2 - low - n1 + 1);
-		out_buf[h - 1] = v - 1; // we don't encode 0
-		if (n1) decode_interpolative(is, out_buf, n1, low, v - 1);
-		if (n2) decode_interpolative(is, out_buf + h, n2, v + 1, high);
+		// the tree has at most 33 levels for 32 bit lists
+		std::array<pending_range, 64> stack;
+		size_t						  top = 0;
+		pending_range				  cur = {0, n, 1, u + 1};
+		while (true) {
+			if (t_range && cur.low - 1 > hi) break;
+			if (cur.high - cur.low + 1 == cur.n) {
+				for (size_t i = 0; i < cur.n; i++)
+					out_buf[cur.offset + i] = cur.low - 1 + i;
+				if (t_range && cur.high - 1 >= lo && cur.low - 1 <= hi) {
+					size_t b = cur.offset + (lo > cur.low - 1 ? lo - (cur.low - 1) : 0);
+					size_t e = cur.offset + std::min(cur.n, size_t(hi - (cur.low - 1) + 1));
+					first	= std::min(first, b);
+					last	 = std::max(last, e);
+				}
+			} else {
+				size_t   h  = (cur.n + 1) >> 1;
+				size_t   n1 = h - 1;
+				size_t   n2 = cur.n - h;
+				uint64_t r  = cur.high - n2 - cur.low - n1 + 1;
+				uint64_t v  = cur.low + n1 - 1 + read_center_mid(data, pos, safe_end, size, r);
+				out_buf[cur.offset + h - 1] = v - 1; // we don't encode 0
+				if (t_range && v - 1 >= lo && v - 1 <= hi) {
+					first = std::min(first, cur.offset + h - 1);
+					last  = std::max(last, cur.offset + h);
+				}
+				if (n1) {
+					if (n2) stack[top++] = {cur.offset + h, n2, v + 1, cur.high};
+					cur.n	= n1;
+					cur.high = v - 1;
+					continue;
+				}
+				if (n2) {
+					cur = {cur.offset + h, n2, v + 1, cur.high};
+					continue;
+				}
+			}
+			if (top == 0) break;
+			cur = stack[--top];
+		}
+		is.seek(pos);
+		if (first > last) first = last;
 	}
 
 public:
@@ -985,9 +1165,18 @@ public:
 	template <class t_bit_istream, class T>
 	inline void decode(const t_bit_istream& is, T* out_buf, size_t n, size_t u) const
 	{
-		size_t low  = 1;
-		size_t high = u + 1;
-		decode_interpolative(is, out_buf, n, low, high);
+		size_t first, last;
+		decode_iterative<false>(is, out_buf, n, u, 0, u, first, last);
+	}
+
+	// decodes only as much of the list as needed to find the values in
+	// [lo,hi]. they end up in out_buf[first,last) at their list positions;
+	// the rest of out_buf is undefined. the stream is left inside the list.
+	template <class t_bit_istream, class T>
+	inline void decode_range(const t_bit_istream& is, T* out_buf, size_t n, size_t u, uint64_t lo,
+	uint64_t hi, size_t& first, size_t& last) const
+	{
+		decode_iterative<true>(is, out_buf, n, u, lo, hi, first, last);
 	}
 };
 
@@ -1040,9 +1229,13 @@ public:
 		}
 	}
 
+	// the low parts are unpacked with a kernel specialized on their width
+	// and the high parts are taken from the set bits of the upper half a
+	// word at a time: the i-th set bit at position b holds high part b - i.
 	template <class t_bit_istream, class T>
 	inline void decode(const t_bit_istream& is, T* out_buf, size_t n, size_t u) const
 	{
+		if (n == 0) return;
 		uint8_t logm	  = sdsl::bits::hi(n) + 1;
 		uint8_t logu	  = sdsl::bits::hi(u) + 1;
 		uint8_t width_low = 0;
@@ -1054,17 +1247,276 @@ public:
 			if (logm == logu) logm--;
 			width_low = logu - logm;
 		}
-		for (size_t i = 0; i < n; i++) {
-			auto low   = is.get_int(width_low);
-			out_buf[i] = low;
+		uint64_t low_start = is.tellg();
+		size_t   n_fast	= fast_unpack_count(is, low_start, n, width_low);
+		if (n_fast) {
+			low_unpacker<32>::unpack(width_low, (const uint8_t*)is.data(), low_start, out_buf, n_fast);
+		}
+		is.seek(low_start + n_fast * width_low);
+		for (size_t i = n_fast; i < n; i++) {
+			out_buf[i] = is.get_int(width_low);
 		}
 		// read high
-		size_t last_high = 0;
+		const uint64_t* data	 = is.data();
+		uint64_t		high_start = is.tellg();
+		uint64_t		word_idx   = high_start >> 6;
+		uint64_t		word	   = data[word_idx] & (~uint64_t(0) << (high_start & 63));
+		uint64_t		bit_pos	= 0;
+		size_t			i		   = 0;
+		while (true) {
+			while (word == 0)
+				word = data[++word_idx];
+			do {
+				bit_pos = (word_idx << 6) + __builtin_ctzll(word);
+				out_buf[i] += T(bit_pos - high_start - i) << width_low;
+				word &= word - 1;
+				if (++i == n) {
+					is.seek(bit_pos + 1);
+					return;
+				}
+			} while (word);
+		}
+	}
+
+private:
+	// number of low parts starting at bit pos that can be read with one
+	// unaligned 64 bit load each without reading past the stream
+	template <class t_bit_istream>
+	static size_t fast_unpack_count(const t_bit_istream& is, uint64_t pos, size_t n, uint8_t width)
+	{
+		if (width > 56) return 0;
+		uint64_t limit = ((is.size() + 63) / 64) * 64;
+		if (limit < pos + 64) return 0;
+		return std::min(n, size_t((limit - 64 - pos) / width + 1));
+	}
+
+	template <uint8_t t_width, class T>
+	static void unpack_low(const uint8_t* data, uint64_t pos, T* out, size_t n)
+	{
+		const uint64_t mask = (uint64_t(1) << t_width) - 1;
+		size_t		   i	= 0;
+		for (; i + 4 <= n; i += 4) {
+			out[i]	 = (load64(data, pos) >> (pos & 7)) & mask;
+			out[i + 1] = (load64(data, pos + t_width) >> ((pos + t_width) & 7)) & mask;
+			out[i + 2] = (load64(data, pos + 2 * t_width) >> ((pos + 2 * t_width) & 7)) & mask;
+			out[i + 3] = (load64(data, pos + 3 * t_width) >> ((pos + 3 * t_width) & 7)) & mask;
+			pos += 4 * t_width;
+		}
+		for (; i < n; i++) {
+			out[i] = (load64(data, pos) >> (pos & 7)) & mask;
+			pos += t_width;
+		}
+	}
+
+	static uint64_t load64(const uint8_t* data, uint64_t pos)
+	{
+		uint64_t x;
+		memcpy(&x, data + (pos >> 3), sizeof(x));
+		return x;
+	}
+
+	// dispatches a runtime width to unpack_low<width>
+	template <uint8_t t_width, bool t_dummy = true>
+	struct low_unpacker {
+		template <class T>
+		static void unpack(uint8_t width, const uint8_t* data, uint64_t pos, T* out, size_t n)
+		{
+			if (width == t_width) {
+				unpack_low<t_width>(data, pos, out, n);
+			} else {
+				low_unpacker<t_width - 1>::unpack(width, data, pos, out, n);
+			}
+		}
+	};
+
+	// widths above 32 only occur for 64 bit universes
+	template <bool t_dummy>
+	struct low_unpacker<0, t_dummy> {
+		template <class T>
+		static void unpack(uint8_t width, const uint8_t* data, uint64_t pos, T* out, size_t n)
+		{
+			const uint64_t mask = (uint64_t(1) << width) - 1;
+			for (size_t i = 0; i < n; i++) {
+				out[i] = (load64(data, pos) >> (pos & 7)) & mask;
+				pos += width;
+			}
+		}
+	};
+};
+
+// rANS over the magnitudes of integers. values below 16 are symbols of their
+// own, larger values are bucketed by their highest two bits and the
+// remaining bits are stored verbatim. the symbol frequencies of every
+// sequence are normalized to 2^scale and stored in front of it. four
+// interleaved 32 bit states renormalize 16 bits at a time, so consecutive
+// symbols decode independently of each other.
+//
+//   [scale:4][alphabet:7][freqs:gamma][words:32][16 bit words][raw bits]
+struct rans {
+	static std::string type() { return "rans"; }
+
+	static const uint32_t lower_bound = 1u << 16;
+	static const size_t   num_states  = 4;
+	static const uint32_t max_symbols = 72;
+
+	static uint32_t symbol(uint32_t v)
+	{
+		if (v < 16) return v;
+		uint32_t e = sdsl::bits::hi(v);
+		return 16 + 2 * (e - 4) + ((v >> (e - 1)) & 1);
+	}
+
+	static uint8_t extra_bits(uint32_t sym) { return sym < 16 ? 0 : (sym - 16) / 2 + 3; }
+
+	static uint32_t base(uint32_t sym)
+	{
+		if (sym < 16) return sym;
+		uint32_t e = (sym - 16) / 2 + 4;
+		return (1u << e) | ((sym & 1) << (e - 1));
+	}
+
+	template <class t_bit_ostream, class T>
+	inline void encode(t_bit_ostream& os, const T* in_buf, size_t n) const
+	{
+		static thread_local std::vector<uint16_t> words;
+		std::array<uint32_t, max_symbols> freq{};
+		for (size_t i = 0; i < n; i++)
+			freq[symbol(in_buf[i])]++;
+		uint32_t alphabet = max_symbols;
+		while (alphabet > 1 && freq[alphabet - 1] == 0)
+			alphabet--;
+		uint8_t scale = std::min(12, std::max(8, int(sdsl::bits::hi(std::max(n, size_t(1)))) + 1));
+		normalize(freq, alphabet, n, scale);
+
+		std::array<uint32_t, max_symbols> start{};
+		os.put_int(scale, 4);
+		os.put_int(alphabet, 7);
+		for (uint32_t s = 0; s < alphabet; s++) {
+			os.put_gamma(freq[s] + 1);
+			if (s) start[s] = start[s - 1] + freq[s - 1];
+		}
+
+		// symbols are encoded back to front, the words are reversed below
+		words.clear();
+		std::array<uint64_t, num_states> x;
+		x.fill(lower_bound);
+		for (size_t i = n; i-- > 0;) {
+			uint32_t  sym   = symbol(in_buf[i]);
+			uint64_t& state = x[i % num_states];
+			uint64_t  x_max = (uint64_t(lower_bound >> scale) << 16) * freq[sym];
+			while (state >= x_max) {
+				words.push_back(state & 0xFFFF);
+				state >>= 16;
+			}
+			state = ((state / freq[sym]) << scale) + (state % freq[sym]) + start[sym];
+		}
+		for (size_t j = num_states; j-- > 0;) {
+			words.push_back(x[j] & 0xFFFF);
+			words.push_back(x[j] >> 16);
+		}
+
+		os.put_int(words.size(), 32);
+		os.expand_if_needed(16ULL * words.size() + 32ULL * n + 64);
+		os.align8();
+		uint8_t* words_out = os.cur_data8();
+		for (size_t k = words.size(); k-- > 0;) {
+			memcpy(words_out, &words[k], sizeof(uint16_t));
+			words_out += sizeof(uint16_t);
+		}
+		os.skip(16ULL * words.size());
 		for (size_t i = 0; i < n; i++) {
-			auto cur_high = is.get_unary();
-			auto high	 = last_high + cur_high;
-			last_high	 = high;
-			out_buf[i]	= (high << width_low) + out_buf[i];
+			uint32_t sym = symbol(in_buf[i]);
+			if (sym >= 16) os.put_int_no_size_check(in_buf[i] - base(sym), extra_bits(sym));
+		}
+	}
+
+	template <class t_bit_istream, class T>
+	inline void decode(const t_bit_istream& is, T* out_buf, size_t n) const
+	{
+		// every slot of the 2^scale range maps to its symbol, its frequency
+		// and its offset into the symbol's range
+		struct slot_entry {
+			uint16_t freq;
+			uint16_t offset;
+			uint8_t  sym;
+		};
+		static thread_local std::vector<slot_entry> lookup;
+		std::array<uint32_t, max_symbols>		   sym_base;
+		std::array<uint8_t, max_symbols>			sym_extra;
+		uint8_t									 scale	= is.get_int(4);
+		uint32_t									alphabet = is.get_int(7);
+		uint32_t									mask	 = (1u << scale) - 1;
+		lookup.resize(1ULL << scale);
+		for (uint32_t s = 0, cum = 0; s < alphabet; s++) {
+			uint32_t freq = is.get_gamma() - 1;
+			for (uint32_t j = 0; j < freq; j++)
+				lookup[cum + j] = slot_entry{uint16_t(freq), uint16_t(j), uint8_t(s)};
+			sym_base[s]  = base(s);
+			sym_extra[s] = extra_bits(s);
+			cum += freq;
+		}
+
+		// the words are read directly from memory, the raw bits follow them
+		size_t num_words = is.get_int(32);
+		is.align8();
+		const uint8_t* words_in = is.cur_data8();
+		is.skip(16ULL * num_words);
+		auto next_word = [&]() {
+			uint16_t w;
+			memcpy(&w, words_in, sizeof(uint16_t));
+			words_in += sizeof(uint16_t);
+			return uint32_t(w);
+		};
+		std::array<uint32_t, num_states> x;
+		for (size_t j = 0; j < num_states; j++) {
+			x[j] = next_word() << 16;
+			x[j] |= next_word();
+		}
+		auto decode_one = [&](uint32_t& state, T& out) {
+			const slot_entry& e = lookup[state & mask];
+			state				= e.freq * (state >> scale) + e.offset;
+			if (state < lower_bound) state = (state << 16) | next_word();
+			out = sym_base[e.sym] + is.get_int(sym_extra[e.sym]);
+		};
+		size_t i = 0;
+		for (; i + num_states <= n; i += num_states) {
+			decode_one(x[0], out_buf[i]);
+			decode_one(x[1], out_buf[i + 1]);
+			decode_one(x[2], out_buf[i + 2]);
+			decode_one(x[3], out_buf[i + 3]);
+		}
+		for (; i < n; i++)
+			decode_one(x[i % num_states], out_buf[i]);
+	}
+
+private:
+	// scale the counts of the n symbols to frequencies summing to 2^scale,
+	// keeping every symbol that occurs
+	static void normalize(std::array<uint32_t, max_symbols>& freq, uint32_t alphabet, size_t n, uint8_t scale)
+	{
+		uint64_t total = uint64_t(1) << scale;
+		if (n == 0) {
+			freq[0] = total;
+			return;
+		}
+		uint64_t sum = 0;
+		for (uint32_t s = 0; s < alphabet; s++) {
+			if (freq[s] == 0) continue;
+			freq[s] = std::max(uint64_t(1), uint64_t(freq[s]) * total / n);
+			sum += freq[s];
+		}
+		while (sum != total) {
+			uint32_t largest = 0;
+			for (uint32_t s = 1; s < alphabet; s++)
+				if (freq[s] > freq[largest]) largest = s;
+			if (sum < total) {
+				freq[largest] += total - sum;
+				sum = total;
+			} else {
+				uint64_t take = std::min(uint64_t(freq[largest] - 1), sum - total);
+				freq[largest] -= take;
+				sum -= take;
+			}
 		}
 	}
 };
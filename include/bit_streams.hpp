@@ -2,6 +2,24 @@
 
 #include "sdsl/int_vector.hpp"
 
+// read-only view of bits owned by someone else. lets one bit_istream type read
+// from a loaded bit_vector as well as from an mmapped int_vector_mapper.
+struct bit_view {
+	using size_type = sdsl::bit_vector::size_type;
+
+	bit_view() {}
+	template <class t_bv>
+	explicit bit_view(const t_bv& bv) : m_data(bv.data()), m_size(bv.size())
+	{
+	}
+
+	const uint64_t* data() const { return m_data; }
+	size_type		size() const { return m_size; }
+
+private:
+	const uint64_t* m_data = nullptr;
+	size_type		m_size = 0;
+};
 
 struct bit_nullstream {
 public:
@@ -308,8 +326,9 @@ public:
 			data_ptr++;
 			in_word_offset = 0;
 		}
-		// align 128 if necessary
-		if (((uintptr_t)data_ptr & 0x0F) != 0) {
+		// align 128 relative to the start of the stream so the layout does
+		// not depend on where the underlying buffer lives in memory
+		if (((data_ptr - m_bv.data()) & 1) != 0) {
 			data_ptr++;
 		}
 	}
@@ -318,7 +337,7 @@ public:
 	{
 		auto mod = in_word_offset % 8;
 		if (mod != 0) {
-			in_word_offset += mod;
+			in_word_offset += (8 - mod);
 			if (in_word_offset >= 64) {
 				data_ptr++;
 				in_word_offset = 0;
@@ -483,8 +502,9 @@ public:
 			data_ptr++;
 			in_word_offset = 0;
 		}
-		// align 128 if necessary
-		if (((uintptr_t)data_ptr & 0x0F) != 0) {
+		// align 128 relative to the start of the stream so the layout does
+		// not depend on where the underlying buffer lives in memory
+		if (((data_ptr - m_bv.data()) & 1) != 0) {
 			data_ptr++;
 		}
 	}
@@ -520,6 +540,7 @@ public:
 	}
 	bool eof() const { return tellg() == m_bv.size(); }
 	explicit operator bool() const { return !eof(); }
+	size_type		size() const { return m_bv.size(); }
 	const uint64_t* data() const { return m_bv.data(); }
 	const uint64_t* cur_data() const { return data_ptr; }
 	const uint8_t*  cur_data8() const
@@ -26,6 +26,8 @@ struct collection {
 #define DOCS_NAME "raw_data.docs"
 #define FREQS_NAME "raw_data.freqs"
 #define META_NAME "raw_data.meta"
+#define DOCLENS_NAME "raw_data.doclens"
+#define BLOCKMAX_NAME "raw_data.blockmax"
 
 struct invidx_collection : public collection {
 	invidx_collection(const std::string& p) : collection(p)
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "utils.hpp"
+#include "logging.hpp"
+
+#include "sdsl/int_vector_mapper.hpp"
+
+#include <sys/mman.h>
+
+// one list of a d2si file. points into the mapped file, nothing is copied.
+struct d2si_list {
+	d2si_list() {}
+	d2si_list(const uint32_t* d, uint32_t n) : data(d), len(n) {}
+
+	const uint32_t* data = nullptr;
+	uint32_t		len  = 0;
+
+	const uint32_t* begin() const { return data; }
+	const uint32_t* end() const { return data + len; }
+	size_t			size() const { return len; }
+	uint32_t		operator[](size_t i) const { return data[i]; }
+};
+
+// the lists of a d2si file: [len][len integers][len][len integers]...
+struct d2si_lists {
+	struct iterator {
+		const uint32_t* m_cur;
+
+		d2si_list operator*() const { return d2si_list(m_cur + 1, *m_cur); }
+		iterator& operator++()
+		{
+			m_cur += 1 + *m_cur;
+			return *this;
+		}
+		bool operator!=(const iterator& other) const { return m_cur != other.m_cur; }
+		bool operator==(const iterator& other) const { return m_cur == other.m_cur; }
+	};
+
+	const uint32_t* m_begin = nullptr;
+	const uint32_t* m_end	= nullptr;
+
+	iterator begin() const { return iterator{m_begin}; }
+	iterator end() const { return iterator{m_end}; }
+};
+
+// memory maps the .docs and .freqs files of a d2si input prefix. the docs
+// file starts with a list holding the number of documents. both files are
+// checked to be complete and to have lists of the same lengths up front.
+struct d2si_reader {
+	using mapper_type = sdsl::int_vector_mapper<32, std::ios_base::in>;
+
+	d2si_reader(std::string input_prefix)
+	{
+		std::string input_docids = input_prefix + ".docs";
+		std::string input_freqs  = input_prefix + ".freqs";
+		if (!utils::file_exists(input_docids)) {
+			LOG(FATAL) << "input prefix does not contain docids file: " << input_docids;
+			throw std::runtime_error("input prefix does not contain docids file.");
+		}
+		if (!utils::file_exists(input_freqs)) {
+			LOG(FATAL) << "input prefix does not contain freqs file: " << input_freqs;
+			throw std::runtime_error("input prefix does not contain freqs file.");
+		}
+		m_docs.reset(new mapper_type(input_docids, true));
+		m_freqs.reset(new mapper_type(input_freqs, true));
+
+		auto doc_ptr = map(*m_docs);
+		if (m_docs->size() < 2 || doc_ptr[0] != 1) {
+			LOG(ERROR) << "docids file does not start with the number of documents: " << input_docids;
+			throw std::runtime_error("docids file does not start with the number of documents.");
+		}
+		m_num_docs = doc_ptr[1];
+		m_doc_lists.m_begin  = doc_ptr + 2;
+		m_doc_lists.m_end	= doc_ptr + m_docs->size();
+		m_freq_lists.m_begin = map(*m_freqs);
+		m_freq_lists.m_end   = m_freq_lists.m_begin + m_freqs->size();
+
+		uint64_t num_freqs	  = 0;
+		m_num_lists			  = count_lists(m_doc_lists, input_docids, m_num_postings);
+		size_t num_freq_lists = count_lists(m_freq_lists, input_freqs, num_freqs);
+		if (m_num_lists != num_freq_lists || m_num_postings != num_freqs) {
+			LOG(ERROR) << "docids and freqs files do not contain the same lists";
+			throw std::runtime_error("docids and freqs files do not contain the same lists.");
+		}
+		check_list_lens(m_doc_lists, m_freq_lists);
+	}
+
+	uint64_t num_docs() const { return m_num_docs; }
+	uint64_t num_lists() const { return m_num_lists; }
+	uint64_t num_postings() const { return m_num_postings; }
+
+	const d2si_lists& docs() const { return m_doc_lists; }
+	const d2si_lists& freqs() const { return m_freq_lists; }
+
+private:
+	static const uint32_t* map(const mapper_type& m)
+	{
+		auto ptr = (const uint32_t*)m.data();
+		// the builders stream over the files once
+		madvise((void*)ptr, m.size() * sizeof(uint32_t), MADV_SEQUENTIAL);
+		return ptr;
+	}
+
+	// walk the list headers so truncated files are caught before anything
+	// reads past the end of the mapping
+	static size_t count_lists(const d2si_lists& lists, const std::string& file, uint64_t& num_postings)
+	{
+		size_t			num_lists = 0;
+		const uint32_t* cur		  = lists.m_begin;
+		while (cur < lists.m_end) {
+			if (uint64_t(lists.m_end - cur - 1) < *cur) {
+				LOG(ERROR) << "truncated list " << num_lists << " in " << file;
+				throw std::runtime_error("truncated d2si file.");
+			}
+			num_postings += *cur;
+			cur += 1 + *cur;
+			num_lists++;
+		}
+		return num_lists;
+	}
+
+	// every doc list needs a freq list of the same length, the builders
+	// read freqs[i] for all docids of a list
+	static void check_list_lens(const d2si_lists& doc_lists, const d2si_lists& freq_lists)
+	{
+		size_t list_id  = 0;
+		auto   freq_itr = freq_lists.begin();
+		for (auto doc_itr = doc_lists.begin(); doc_itr != doc_lists.end(); ++doc_itr, ++freq_itr) {
+			if ((*doc_itr).size() != (*freq_itr).size()) {
+				LOG(ERROR) << "freq and doc_id lists not same len: list " << list_id << " has "
+						   << (*doc_itr).size() << " docids and " << (*freq_itr).size() << " freqs";
+				throw std::runtime_error("freq and doc_id lists not same len.");
+			}
+			list_id++;
+		}
+	}
+
+	std::unique_ptr<mapper_type> m_docs;
+	std::unique_ptr<mapper_type> m_freqs;
+	d2si_lists					 m_doc_lists;
+	d2si_lists					 m_freq_lists;
+	uint64_t					 m_num_docs	 = 0;
+	uint64_t					 m_num_lists	= 0;
+	uint64_t					 m_num_postings = 0;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <sdsl/int_vector.hpp>
+#include <sdsl/suffix_arrays.hpp>
+#include <string>
+
+template <class t_csa, class t_itr>
+struct factor_itr_csa {
+    const t_csa& sa;
+    t_itr factor_start;
+    t_itr itr;
+    t_itr start;
+    t_itr end;
+    uint64_t sp;
+    uint64_t ep;
+    uint64_t len;
+    bool done;
+
+    factor_itr_csa(const t_csa& _sa, t_itr begin, t_itr _end)
+        : sa(_sa)
+        , factor_start(begin)
+        , itr(begin)
+        , start(begin)
+        , end(_end)
+        , sp(0)
+        , ep(_sa.size() - 1)
+        , len(0)
+        , done(false)
+    {
+        find_next_factor();
+    }
+    factor_itr_csa& operator++()
+    {
+        find_next_factor();
+        return *this;
+    }
+
+    inline void find_next_factor()
+    {
+        if (itr == end) {
+            done = true;
+            return;
+        }
+        sp = 0;
+        ep = sa.size() - 1;
+        len = 0;
+
+        /* extend to the left in the reversed dictionary as long as possible */
+        while (itr != end) {
+            uint64_t lb, rb;
+            auto sym = typename t_csa::char_type(*itr) + 1;
+            if (sdsl::backward_search(sa, sp, ep, sym, lb, rb) == 0)
+                break;
+            sp = lb;
+            ep = rb;
+            ++itr;
+            ++len;
+        }
+        if (len == 0) { // unknown symbol factor found
+            ++itr;
+        }
+        factor_start = itr;
+    }
+    inline bool finished() const
+    {
+        return done;
+    }
+};
+
+/*
+    dictionary index based on a compressed suffix array of the reversed
+    dictionary. backward search extends a match of the reversed text to
+    the left, which is the factor growing to the right in the dictionary.
+    it needs a fraction of the space of dict_index_sa, which keeps the
+    suffix array, a copy of the dictionary and the 3-gram cache, at the
+    cost of a rank on the bwt per symbol and a sa lookup per factor.
+
+    the dictionary can contain any byte, so symbols are shifted by one to
+    keep 0 free for the sentinel and an integer alphabet csa is used.
+ */
+template <class t_csa = sdsl::csa_wt<sdsl::wt_huff_int<>, 32, 64, sdsl::sa_order_sa_sampling<>,
+              sdsl::isa_sampling<>, sdsl::int_alphabet<> > >
+struct dict_index_csa {
+    typedef typename sdsl::int_vector<>::size_type size_type;
+    t_csa sa;
+
+    static std::string name()
+    {
+        return "csa";
+    }
+
+    std::string type() const
+    {
+        return "dict_index_csa-" + sdsl::util::class_to_hash(*this);
+    }
+
+    dict_index_csa(sdsl::int_vector<8>& dict)
+    {
+        sdsl::int_vector<> rev(dict.size(), 0, 9);
+        for (size_t i = 0; i < dict.size(); i++) {
+            rev[i] = uint64_t(dict[dict.size() - 1 - i]) + 1;
+        }
+        sdsl::construct_im(sa, rev, 0);
+    }
+
+    size_type size_in_bytes() const
+    {
+        return sdsl::size_in_bytes(sa);
+    }
+
+    template <class t_itr>
+    factor_itr_csa<t_csa, t_itr> factorize(t_itr itr, t_itr end) const
+    {
+        return factor_itr_csa<t_csa, t_itr>(sa, itr, end);
+    }
+
+    bool is_reverse() const
+    {
+        return true;
+    }
+};
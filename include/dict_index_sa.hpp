@@ -3,6 +3,9 @@
 #include <sdsl/int_vector.hpp>
 #include <string>
 #include <sdsl/rmq_support.hpp>
+#include <sdsl/construct_sa.hpp>
+
+#include <emmintrin.h>
 
 template <class t_itr>
 struct factor_itr_sa {
@@ -10,7 +13,8 @@ struct factor_itr_sa {
     const sdsl::int_vector<8>& text;
     const sdsl::int_vector<>& cache;
     decltype(sa.begin()) sa_start;
-    decltype(text.begin()) text_start;
+    const uint8_t* text_data;
+    uint64_t text_size;
     t_itr factor_start;
     t_itr itr;
     t_itr start;
@@ -21,13 +25,14 @@ struct factor_itr_sa {
     uint64_t len;
     uint8_t sym;
     bool done;
-    
+
     factor_itr_sa(const sdsl::int_vector<>& _sa, const sdsl::int_vector<8>& _text, const sdsl::int_vector<>& _cache, t_itr begin, t_itr _end)
         : sa(_sa)
         , text(_text)
         , cache(_cache)
         , sa_start(sa.begin())
-        , text_start(text.begin())
+        , text_data((const uint8_t*)text.data())
+        , text_size(text.size())
         , factor_start(begin)
         , itr(begin)
         , start(begin)
@@ -46,16 +51,47 @@ struct factor_itr_sa {
         return *this;
     }
 
+    // symbol at text position pos. suffixes ending before pos sort in front
+    // of all their extensions, so the end of the dictionary is -1.
+    inline int text_sym_at(uint64_t pos) const
+    {
+        if (pos >= text_size)
+            return -1;
+        return text_data[pos];
+    }
+
+    // length of the common prefix of a and b up to max_len, 16 bytes at a time
+    static inline size_t common_prefix(const uint8_t* a, const uint8_t* b, size_t max_len)
+    {
+        size_t len = 0;
+        while (len + 16 <= max_len) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(a + len));
+            __m128i y = _mm_loadu_si128((const __m128i*)(b + len));
+            uint32_t neq = ~_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xFFFF;
+            if (neq)
+                return len + __builtin_ctz(neq);
+            len += 16;
+        }
+        while (len < max_len && a[len] == b[len])
+            len++;
+        return len;
+    }
+
     bool refine_bounds(uint64_t& lb, uint64_t& rb, uint8_t pat_sym, size_t offset)
     {
+        // the suffixes in [lb,rb] share a prefix as long as the common prefix
+        // of the first and the last one. within it the interval stays the
+        // same and only the pattern has to be checked.
+        int first_sym = text_sym_at(sa[lb] + offset);
+        if (first_sym == text_sym_at(sa[rb] + offset))
+            return first_sym == pat_sym;
+
         auto left = sa_start + lb;
-        auto right = sa_start + rb;
-        auto count = std::distance(left, right);
+        auto count = rb - lb + 1;
         while (count > 0) {
             auto step = count / 2;
             auto mid = left + step;
-            uint8_t text_sym = *(text_start + *mid + offset);
-            if (text_sym < pat_sym) {
+            if (text_sym_at(*mid + offset) < pat_sym) {
                 count -= step + 1;
                 left = ++mid;
             }
@@ -64,14 +100,11 @@ struct factor_itr_sa {
             }
         }
         auto sp = left;
-        left = sa_start + lb;
-        right = sa_start + rb;
-        count = std::distance(left, right);
+        count = (sa_start + rb + 1) - sp;
         while (count > 0) {
             auto step = count / 2;
             auto mid = left + step;
-            uint8_t text_sym = *(text_start + *mid + offset);
-            if (text_sym <= pat_sym) {
+            if (text_sym_at(*mid + offset) <= pat_sym) {
                 count -= step + 1;
                 left = ++mid;
             }
@@ -80,18 +113,106 @@ struct factor_itr_sa {
             }
         }
         auto ep = left;
-        uint8_t text_sym = *(text_start + *left + offset);
-        if (text_sym != pat_sym)
-            ep--;
 
-        if (sp <= ep) {
+        if (sp < ep) {
             lb = std::distance(sa_start, sp);
-            rb = std::distance(sa_start, ep);
+            rb = std::distance(sa_start, ep) - 1;
             return true;
         }
         return false;
     }
 
+    // common prefix of the pattern [pat,pat+m) and the suffix at text
+    // position pos, comparing from offset on
+    inline size_t suffix_lcp(const uint8_t* pat, size_t m, uint64_t pos, size_t offset) const
+    {
+        if (pos + offset >= text_size || offset >= m)
+            return offset;
+        size_t max_len = std::min<size_t>(m, text_size - pos) - offset;
+        return offset + common_prefix(pat + offset, text_data + pos + offset, max_len);
+    }
+
+    // true if the suffix at pos sorts before the pattern, given their lcp
+    inline bool suffix_less(const uint8_t* pat, size_t m, uint64_t pos, size_t lcp) const
+    {
+        if (lcp == m)
+            return false;
+        return text_sym_at(pos + lcp) < pat[lcp];
+    }
+
+    // longest match of [pat,pat+m) among the suffixes in [lb,rb], all of
+    // which share the first offset symbols with it. one binary search for
+    // the whole pattern: the longest match is next to where the pattern
+    // would be inserted. comparisons skip the min(lcp) the pattern has
+    // with both interval bounds. returns the match length and sets lb=rb
+    // to the first suffix of the interval of the match, as the symbol by
+    // symbol refinement would.
+    size_t longest_match(uint64_t& lb, uint64_t& rb, const uint8_t* pat, size_t m, size_t offset)
+    {
+        uint64_t first = lb;
+        size_t first_lcp = suffix_lcp(pat, m, sa[lb], offset);
+        size_t llcp = first_lcp;
+        size_t rlcp;
+        if (!suffix_less(pat, m, sa[lb], llcp)) {
+            rb = lb;
+            return llcp;
+        }
+        rlcp = suffix_lcp(pat, m, sa[rb], offset);
+        if (suffix_less(pat, m, sa[rb], rlcp)) {
+            lb = rb;
+        }
+        else {
+            // suffix(lb) < pattern <= suffix(rb)
+            while (rb - lb > 1) {
+                uint64_t mid = lb + (rb - lb) / 2;
+                uint64_t pos = sa[mid];
+                size_t lcp = suffix_lcp(pat, m, pos, std::min(llcp, rlcp));
+                if (suffix_less(pat, m, pos, lcp)) {
+                    lb = mid;
+                    llcp = lcp;
+                }
+                else {
+                    rb = mid;
+                    rlcp = lcp;
+                }
+            }
+        }
+        size_t len = std::max(llcp, rlcp);
+        if (first_lcp >= len) {
+            lb = rb = first;
+            return len;
+        }
+        // the suffixes sharing len symbols with the pattern end at lb or rb,
+        // search back for the first one. the interval is usually short, so
+        // gallop to the left before the binary search. lcps in between are
+        // at least the lcp with the left bound.
+        uint64_t hi = rlcp >= llcp ? rb : lb;
+        uint64_t lo = first;
+        size_t lo_lcp = first_lcp;
+        for (uint64_t step = 1; hi - lo > step; step *= 2) {
+            size_t lcp = suffix_lcp(pat, len, sa[hi - step], first_lcp);
+            if (lcp < len) {
+                lo = hi - step;
+                lo_lcp = lcp;
+                break;
+            }
+            hi -= step;
+        }
+        while (hi - lo > 1) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            size_t lcp = suffix_lcp(pat, len, sa[mid], lo_lcp);
+            if (lcp < len) {
+                lo = mid;
+                lo_lcp = lcp;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        lb = rb = hi;
+        return len;
+    }
+
     inline void find_next_factor()
     {
         if (itr == end) {
@@ -102,37 +223,35 @@ struct factor_itr_sa {
         ep = sa.size() - 1;
         size_t offset = 0;
 
-        // ask the cache!
-        /*
-        if (std::distance(itr, end) >= 3) {
-            uint32_t two_gram = uint32_t(*itr) << 16 | uint32_t(*(itr + 1)) << 8 | uint32_t(*(itr + 2));
-            sp = cache[two_gram * 2];
-            ep = cache[two_gram * 2 + 1];
-            if (ep < sp) {
-                sp = 0;
-                ep = sa.size() - 1;
-            }
-            else {
-                offset += 3;
-                itr += 3;
+        // ask the cache for the interval of the first 3 symbols and search
+        // the rest of the pattern within it. if they do not occur the factor
+        // is shorter than 3 and found symbol by symbol below.
+        size_t remaining = std::distance(itr, end);
+        if (remaining >= 3) {
+            uint32_t three_gram = uint32_t(*itr) << 16 | uint32_t(*(itr + 1)) << 8 | uint32_t(*(itr + 2));
+            uint64_t csp = cache[three_gram * 2];
+            uint64_t cep = cache[three_gram * 2 + 1];
+            if (csp <= cep) {
+                sp = csp;
+                ep = cep;
+                len = longest_match(sp, ep, &*itr, remaining, 3);
+                itr += len;
+                factor_start = itr;
+                return;
             }
         }
-        */
 
         /* refine bounds as long as possible */
-        while (itr != end && refine_bounds(sp, ep, *itr, offset)) {
+        while (sp != ep && itr != end && refine_bounds(sp, ep, *itr, offset)) {
             ++itr;
             ++offset;
-            if (sp == ep)
-                break;
         }
-        if (sp == ep) {
-            auto text_itr = text_start + sa[sp] + offset;
-            while (itr != end && *text_itr == *itr) {
-                ++itr;
-                ++text_itr;
-                ++offset;
-            }
+        if (sp == ep && itr != end) {
+            uint64_t text_pos = sa[sp] + offset;
+            size_t max_len = std::min<size_t>(std::distance(itr, end), text_size - std::min(text_pos, text_size));
+            size_t matched = common_prefix(&*itr, text_data + text_pos, max_len);
+            itr += matched;
+            offset += matched;
         }
 
         len = offset;
@@ -153,6 +272,11 @@ struct dict_index_sa {
     sdsl::int_vector<8> text;
     sdsl::int_vector<> cache;
 
+    static std::string name()
+    {
+        return "sa";
+    }
+
     std::string type() const
     {
         return "dict_index_sa-" + sdsl::util::class_to_hash(*this);
@@ -163,39 +287,32 @@ struct dict_index_sa {
         sa.width(sdsl::bits::hi(text.size()) + 1);
         sdsl::algorithm::calculate_sa((const uint8_t*)text.data(), text.size(), sa);
         {
+            // sa interval [sp,ep] of every 3-gram, empty ones are [1,0]. the
+            // suffixes starting with a 3-gram are consecutive in the sa and
+            // the last two suffixes are too short to start one.
             size_t num_kgrams = 256 * 256 * 256;
-            sdsl::int_vector<> counts(num_kgrams);
-            uint32_t cur_k_gram = uint32_t(text[0]) << 16 | uint32_t(text[1]) << 8 | uint32_t(text[2]);
-            counts[cur_k_gram]++;
-            for (size_t i = 3; i < text.size(); i++) {
-                cur_k_gram = ((cur_k_gram << 8) & 0xFFFF00) | uint32_t(text[i]);
-                counts[cur_k_gram]++;
-            }
-
-            /* fix up some counts at the end */
-            //counts[0] = 1;
-            cur_k_gram = uint32_t(text[text.size() - 2]) << 16 | uint32_t(text[text.size() - 1]) << 8 | uint32_t(text[text.size() - 1]);
-            counts[cur_k_gram]++;
-
-            sdsl::int_vector<> ccounts(num_kgrams);
-            ccounts[0] = 0;
-
-            for (size_t i = 1; i < num_kgrams; i++)
-                ccounts[i] = ccounts[i - 1] + counts[i - 1];
-
-            cache.resize(num_kgrams * 2);
-            for (size_t i = 0; i < num_kgrams; i++) {
-                cache[i * 2] = ccounts[i];
-                cache[i * 2 + 1] = ccounts[i] + counts[i] - 1;
-                if (counts[i] == 0) {
-                    cache[i * 2] += 2;
-                    cache[i * 2 + 1] += 1;
-                }
+            cache = sdsl::int_vector<>(num_kgrams * 2, 0, sdsl::bits::hi(text.size()) + 1);
+            for (size_t i = 0; i < num_kgrams; i++)
+                cache[i * 2] = 1;
+            uint32_t last_k_gram = num_kgrams;
+            for (size_t i = 0; i < sa.size(); i++) {
+                uint64_t pos = sa[i];
+                if (pos + 3 > text.size())
+                    continue;
+                uint32_t cur_k_gram = uint32_t(text[pos]) << 16 | uint32_t(text[pos + 1]) << 8 | uint32_t(text[pos + 2]);
+                if (cur_k_gram != last_k_gram)
+                    cache[cur_k_gram * 2] = i;
+                cache[cur_k_gram * 2 + 1] = i;
+                last_k_gram = cur_k_gram;
             }
-            sdsl::util::bit_compress(cache);
         }
     }
 
+    size_type size_in_bytes() const
+    {
+        return sdsl::size_in_bytes(sa) + sdsl::size_in_bytes(text) + sdsl::size_in_bytes(cache);
+    }
+
     template <class t_itr>
     factor_itr_sa<t_itr> factorize(t_itr itr, t_itr end) const
     {
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <sdsl/int_vector.hpp>
+#include <sdsl/qsufsort.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/*
+    suffix array over a dictionary of 32-bit integers. dict_index_sa works
+    on bytes, so integer sequences would only match at byte granularity and
+    factors would break at integer boundaries. here every integer is one
+    symbol and factors are (offset,length) in integers.
+ */
+struct dict_index_sa_u32 {
+    typedef typename sdsl::int_vector<>::size_type size_type;
+    sdsl::int_vector<> sa;
+    const std::vector<uint32_t>& text;
+
+    std::string type() const
+    {
+        return "dict_index_sa_u32";
+    }
+
+    dict_index_sa_u32(const std::vector<uint32_t>& dict) : text(dict)
+    {
+        if (text.empty())
+            return;
+        // qsufsort wants symbols > 0 followed by a 0 sentinel, so map the
+        // integers to their rank in the sorted alphabet starting at 1
+        std::vector<uint32_t> alphabet(text.begin(), text.end());
+        std::sort(alphabet.begin(), alphabet.end());
+        alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+        sdsl::int_vector<> ranks(text.size() + 1, 0, sdsl::bits::hi(alphabet.size()) + 1);
+        for (size_t i = 0; i < text.size(); i++) {
+            ranks[i] = std::lower_bound(alphabet.begin(), alphabet.end(), text[i]) - alphabet.begin() + 1;
+        }
+        sdsl::int_vector<> sa_with_sentinel;
+        sdsl::qsufsort::construct_sa(sa_with_sentinel, ranks);
+
+        // the sentinel suffix sorts first
+        sa = sdsl::int_vector<>(text.size(), 0, sdsl::bits::hi(text.size()) + 1);
+        for (size_t i = 0; i < text.size(); i++) {
+            sa[i] = sa_with_sentinel[i + 1];
+        }
+    }
+
+    // symbol at text position pos, -1 past the end of the dictionary
+    inline int64_t text_sym_at(uint64_t pos) const
+    {
+        if (pos >= text.size())
+            return -1;
+        return text[pos];
+    }
+
+    // narrow the sa interval [lb,rb] to the suffixes with pat_sym at offset
+    bool refine_bounds(uint64_t& lb, uint64_t& rb, uint32_t pat_sym, size_t offset) const
+    {
+        auto first = sa.begin() + lb;
+        auto last = sa.begin() + rb + 1;
+        auto sp = std::lower_bound(first, last, pat_sym, [&](uint64_t s, uint32_t sym) {
+            return text_sym_at(s + offset) < int64_t(sym);
+        });
+        auto ep = std::upper_bound(sp, last, pat_sym, [&](uint32_t sym, uint64_t s) {
+            return int64_t(sym) < text_sym_at(s + offset);
+        });
+        if (sp == ep)
+            return false;
+        lb = sp - sa.begin();
+        rb = (ep - sa.begin()) - 1;
+        return true;
+    }
+
+    // length of the longest prefix of [itr,end) occurring in the dictionary.
+    // offset is set to one of its occurrences.
+    size_t longest_match(const uint32_t* itr, const uint32_t* end, uint64_t& offset) const
+    {
+        offset = 0;
+        if (text.empty())
+            return 0;
+        uint64_t sp = 0;
+        uint64_t ep = sa.size() - 1;
+        size_t len = 0;
+        while (itr + len != end && refine_bounds(sp, ep, itr[len], len)) {
+            ++len;
+            if (sp == ep)
+                break;
+        }
+        if (len == 0)
+            return 0;
+        offset = sa[sp];
+        /* single candidate left, compare directly */
+        if (sp == ep) {
+            while (itr + len != end && offset + len < text.size() && text[offset + len] == itr[len])
+                ++len;
+        }
+        return len;
+    }
+};
@@ -18,6 +18,9 @@ template <uint32_t t_literal_threshold = 1,
 struct factor_coder_blocked {
     typedef typename sdsl::int_vector<>::size_type size_type;
     enum { literal_threshold = t_literal_threshold };
+    using literal_coder_type = t_coder_literal;
+    using offset_coder_type = t_coder_offset;
+    using len_coder_type = t_coder_len;
     t_coder_literal literal_coder;
     t_coder_offset offset_coder;
     t_coder_len len_coder;
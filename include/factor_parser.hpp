@@ -0,0 +1,279 @@
+#pragma once
+
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+#include "factor_data.hpp"
+#include "factor_selector.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+/*
+    estimated size in bits of a value written by t_coder. the fixed width
+    and vbyte coders are exact. the block compressors (zstd, lzma, ...) are
+    modelled as order-0 coders over the bytes of the values, with one
+    distribution per byte position, trained on the values of a parse.
+ */
+template <class t_coder, class T>
+struct value_cost {
+    static const bool exact = false;
+    uint64_t counts[sizeof(T)][256];
+    double costs[sizeof(T)][256];
+
+    value_cost()
+    {
+        reset();
+        update();
+    }
+
+    void reset()
+    {
+        memset(counts, 0, sizeof(counts));
+    }
+
+    void add(T x)
+    {
+        for (size_t b = 0; b < sizeof(T); b++)
+            counts[b][(uint64_t(x) >> (8 * b)) & 0xFF]++;
+    }
+
+    void update()
+    {
+        for (size_t b = 0; b < sizeof(T); b++) {
+            uint64_t total = 256;
+            for (size_t s = 0; s < 256; s++)
+                total += counts[b][s];
+            for (size_t s = 0; s < 256; s++)
+                costs[b][s] = std::log2(double(total) / double(counts[b][s] + 1));
+        }
+    }
+
+    // scale the costs so the values added sum up to bits, the size the
+    // coder actually needed for them
+    void calibrate(uint64_t bits)
+    {
+        double estimate = 0;
+        for (size_t b = 0; b < sizeof(T); b++)
+            for (size_t s = 0; s < 256; s++)
+                estimate += counts[b][s] * costs[b][s];
+        if (estimate == 0)
+            return;
+        double factor = bits / estimate;
+        for (size_t b = 0; b < sizeof(T); b++)
+            for (size_t s = 0; s < 256; s++)
+                costs[b][s] *= factor;
+    }
+
+    double operator()(T x) const
+    {
+        double bits = 0;
+        for (size_t b = 0; b < sizeof(T); b++)
+            bits += costs[b][(uint64_t(x) >> (8 * b)) & 0xFF];
+        return bits;
+    }
+};
+
+template <class t_exact_cost, class T>
+struct value_cost_exact {
+    static const bool exact = true;
+    void reset() {}
+    void calibrate(uint64_t) {}
+    void add(T) {}
+    void update() {}
+    double operator()(T x) const
+    {
+        return t_exact_cost()(x);
+    }
+};
+
+template <uint8_t t_width>
+struct fixed_cost {
+    template <class T>
+    double operator()(T) const { return t_width; }
+};
+
+struct vbyte_cost {
+    template <class T>
+    double operator()(T x) const { return coder::vbyte().encoded_length(x); }
+};
+
+template <uint8_t t_width, class T>
+struct value_cost<coder::fixed<t_width>, T> : value_cost_exact<fixed_cost<t_width>, T> {
+};
+
+template <class t_int_type, class T>
+struct value_cost<coder::aligned_fixed<t_int_type>, T> : value_cost_exact<fixed_cost<8 * sizeof(t_int_type)>, T> {
+};
+
+template <class T>
+struct value_cost<coder::vbyte, T> : value_cost_exact<vbyte_cost, T> {
+};
+
+template <class T>
+struct value_cost<coder::vbyte_fastpfor, T> : value_cost_exact<vbyte_cost, T> {
+};
+
+/*
+    longest match at every position, the original rlz parse.
+ */
+struct factor_parse_greedy {
+    static std::string type()
+    {
+        return "greedy";
+    }
+
+    template <class t_index, class t_coder>
+    static void parse(const t_index& dict_idx, block_factor_data& fs, t_coder& coder, const uint8_t* data_ptr, size_t size)
+    {
+        auto itr = data_ptr;
+        auto end = itr + size;
+        auto factor_itr = dict_idx.template factorize<decltype(data_ptr)>(itr, end);
+        size_t syms_encoded = 0;
+        while (!factor_itr.finished()) {
+            if (factor_itr.len == 0) {
+                fs.add_factor(coder, itr + syms_encoded, 0, 1);
+                syms_encoded++;
+            } else {
+                uint64_t offset = factor_select_first::pick_offset(dict_idx, factor_itr);
+                fs.add_factor(coder, itr + syms_encoded, offset, factor_itr.len);
+                syms_encoded += factor_itr.len;
+            }
+            ++factor_itr;
+        }
+    }
+};
+
+/*
+    near bit-optimal parse: the cheapest path from the start to the end of
+    the block in the graph with an edge for every literal run up to the
+    literal threshold and every prefix of the longest match at a position.
+    edge costs are estimated with value_cost for the literal, offset and
+    length coders of t_coder, trained on the greedy parse of the block and
+    scaled to the size the block compressors need for its streams.
+
+    the longest match is searched at every position except inside matches
+    longer than sufficient_len. there the match shifted by one is used up
+    to the last sufficient_len positions, which are searched again as a
+    match ending after it can start there.
+    per match only the shortest max_short_lens lengths and the longest
+    one are tried, as the length costs hardly differ beyond that.
+ */
+struct factor_parse_optimal {
+    static const size_t sufficient_len = 64;
+    static const size_t max_short_lens = 16;
+
+    static std::string type()
+    {
+        return "optimal";
+    }
+
+    // size of n values written by a block compressor
+    template <class t_stream_coder, class T>
+    static uint64_t coded_bits(const t_stream_coder& c, const T* values, size_t n)
+    {
+        if (n == 0)
+            return 0;
+        static thread_local sdsl::bit_vector bv;
+        bit_ostream<sdsl::bit_vector> out(bv);
+        c.encode(out, values, n);
+        return out.tellp();
+    }
+
+    template <class t_index, class t_coder>
+    static void parse(const t_index& dict_idx, block_factor_data& fs, t_coder& coder, const uint8_t* data_ptr, size_t size)
+    {
+        static thread_local std::vector<uint32_t> match_len;
+        static thread_local std::vector<uint32_t> match_offset;
+        static thread_local std::vector<double> cost;
+        static thread_local std::vector<uint32_t> edge_len;
+        static thread_local std::vector<uint32_t> path;
+        static thread_local value_cost<typename t_coder::literal_coder_type, uint8_t> literal_cost;
+        static thread_local value_cost<typename t_coder::offset_coder_type, uint32_t> offset_cost;
+        static thread_local value_cost<typename t_coder::len_coder_type, uint32_t> len_cost;
+        const size_t threshold = coder.literal_threshold;
+        match_len.resize(size);
+        match_offset.resize(size);
+
+        // (1) longest match at every position
+        for (size_t i = 0; i < size;) {
+            auto factor_itr = dict_idx.template factorize<decltype(data_ptr)>(data_ptr + i, data_ptr + size);
+            uint64_t len = factor_itr.len;
+            uint64_t offset = len ? factor_select_first::pick_offset(dict_idx, factor_itr) : 0;
+            match_len[i] = len;
+            match_offset[i] = offset;
+            size_t skip = len > sufficient_len ? len - sufficient_len : 0;
+            for (size_t j = 1; j <= skip; j++) {
+                match_len[i + j] = len - j;
+                match_offset[i + j] = offset + j;
+            }
+            i += skip + 1;
+        }
+
+        // (2) train the cost model on the greedy parse
+        for (size_t i = 0; i < size;) {
+            size_t len = std::max<size_t>(match_len[i], 1);
+            fs.add_factor(coder, data_ptr + i, match_offset[i], len);
+            i += len;
+        }
+        literal_cost.reset();
+        offset_cost.reset();
+        len_cost.reset();
+        for (size_t i = 0; i < fs.num_literals; i++)
+            literal_cost.add(fs.literals[i]);
+        for (size_t i = 0; i < fs.num_offsets; i++)
+            offset_cost.add(fs.offsets[i]);
+        for (size_t i = 0; i < fs.num_factors; i++)
+            len_cost.add(fs.lengths[i] - 1);
+        literal_cost.update();
+        offset_cost.update();
+        len_cost.update();
+        if (!decltype(literal_cost)::exact)
+            literal_cost.calibrate(coded_bits(coder.literal_coder, fs.literals.data(), fs.num_literals));
+        if (!decltype(offset_cost)::exact)
+            offset_cost.calibrate(coded_bits(coder.offset_coder, fs.offsets.data(), fs.num_offsets));
+        if (!decltype(len_cost)::exact) {
+            for (size_t i = 0; i < fs.num_factors; i++)
+                fs.lengths[i]--;
+            len_cost.calibrate(coded_bits(coder.len_coder, fs.lengths.data(), fs.num_factors));
+        }
+        fs.reset();
+
+        // (3) shortest path, edge_len[j] is the last factor on the path to j
+        cost.assign(size + 1, std::numeric_limits<double>::max());
+        edge_len.resize(size + 1);
+        cost[0] = 0;
+        auto relax = [&](size_t to, double c, uint32_t len) {
+            if (c < cost[to]) {
+                cost[to] = c;
+                edge_len[to] = len;
+            }
+        };
+        for (size_t i = 0; i < size; i++) {
+            double literals = cost[i];
+            for (size_t k = 1; k <= threshold && i + k <= size; k++) {
+                literals += literal_cost(data_ptr[i + k - 1]);
+                relax(i + k, literals + len_cost(k - 1), k);
+            }
+            size_t len = match_len[i];
+            if (len <= threshold)
+                continue;
+            double match = cost[i] + offset_cost(match_offset[i]);
+            size_t short_end = std::min(len, threshold + max_short_lens);
+            for (size_t k = threshold + 1; k <= short_end; k++)
+                relax(i + k, match + len_cost(k - 1), k);
+            if (len > short_end)
+                relax(i + len, match + len_cost(len - 1), len);
+        }
+
+        // (4) walk the path back and add its factors
+        path.clear();
+        for (size_t j = size; j > 0; j -= edge_len[j])
+            path.push_back(edge_len[j]);
+        size_t pos = 0;
+        for (auto itr = path.rbegin(); itr != path.rend(); ++itr) {
+            fs.add_factor(coder, data_ptr + pos, match_offset[pos], *itr);
+            pos += *itr;
+        }
+    }
+};
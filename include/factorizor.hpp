@@ -6,15 +6,20 @@
 #include "bit_streams.hpp"
 #include "timings.hpp"
 #include "dict_index_sa.hpp"
+#include "dict_index_csa.hpp"
 #include "factor_selector.hpp"
+#include "factor_parser.hpp"
 
 #include <sdsl/int_vector_mapped_buffer.hpp>
 
 #include <cctype>
 #include <future>
+#include <type_traits>
 
 template <uint32_t t_block_size,
-          class t_coder>
+          class t_coder,
+          class t_dict_index = dict_index_sa,
+          class t_parser = factor_parse_greedy>
 struct factorizor {
     
     struct block_encodings {
@@ -30,34 +35,42 @@ struct factorizor {
 
     static std::string type()
     {
-        return "factorizor-" + std::to_string(t_block_size) + "-" + t_coder::type();
+        return "factorizor-" + std::to_string(t_block_size) + "-" + t_dict_index::name() + "-" + t_parser::type() + "-" + t_coder::type();
+    }
+
+    // names earlier versions stored this factorization under. the first
+    // one did not name the dictionary index and kept one block map per
+    // dictionary, so stores sharing a dictionary overwrote each other's
+    // block maps. the second one did not name the parser.
+    static std::vector<std::string> legacy_types()
+    {
+        std::vector<std::string> types;
+        if (!std::is_same<t_parser,factor_parse_greedy>::value)
+            return types;
+        if (std::is_same<t_dict_index,dict_index_sa>::value)
+            types.push_back("factorizor-" + std::to_string(t_block_size) + "-" + t_coder::type());
+        types.push_back("factorizor-" + std::to_string(t_block_size) + "-" + t_dict_index::name() + "-" + t_coder::type());
+        return types;
+    }
+
+    // the block map is keyed by the factorization as stores sharing a
+    // dictionary also share the file hash
+    static std::string block_map_type()
+    {
+        return type() + "-" + block_map_uncompressed<true>::type();
     }
 
     template<class t_enc_stream>
-    static uint64_t factorize_block(dict_index_sa& dict_idx,block_factor_data& fs,t_coder& coder,t_enc_stream& encoded_stream,const uint8_t* data_ptr,size_t size)
+    static uint64_t factorize_block(const t_dict_index& dict_idx,block_factor_data& fs,t_coder& coder,t_enc_stream& encoded_stream,const uint8_t* data_ptr,size_t size)
     {
-        auto itr = data_ptr;
-        auto end = itr + size;
-        auto factor_itr = dict_idx.factorize<decltype(data_ptr)>(itr, end);
         fs.reset();
-        size_t syms_encoded = 0;
-        while (!factor_itr.finished()) {
-            if (factor_itr.len == 0) {
-                fs.add_factor(coder, itr + syms_encoded, 0, 1);
-                syms_encoded++;
-            } else {
-                uint64_t offset = factor_select_first::pick_offset(dict_idx, factor_itr);
-                fs.add_factor(coder, itr + syms_encoded, offset, factor_itr.len);
-                syms_encoded += factor_itr.len;
-            }
-            ++factor_itr;
-        }
+        t_parser::parse(dict_idx, fs, coder, data_ptr, size);
         auto num_factors = fs.encode_current_block(encoded_stream,coder);
         return num_factors;
     }
 
     static block_encodings 
-    factorize_blocks(dict_index_sa& dict_idx,const uint8_t* data_ptr, size_t block_size, size_t blocks_to_encode, size_t id)
+    factorize_blocks(const t_dict_index& dict_idx,const uint8_t* data_ptr, size_t block_size, size_t blocks_to_encode, size_t id)
     {
         block_encodings be;
         be.id = id;
@@ -97,7 +110,8 @@ struct factorizor {
         auto rlz_output_file = col.file_name(hash,type());
         
         LOG(INFO) << "["<<name<<"] "  "create dictionary index";
-        dict_index_sa dict_idx(dict);
+        t_dict_index dict_idx(dict);
+        LOG(INFO) << "["<<name<<"] "  "dictionary index size = " << dict_idx.size_in_bytes() / (1024 * 1024.0) << " MiB";
         const sdsl::int_vector_mapper<8, std::ios_base::in> input(input_file,true);
         auto data_size = input.size();
         auto data_size_mb = data_size / (1024 * 1024.0);
@@ -169,12 +183,12 @@ struct factorizor {
         double avg_factor_len = double(bytes_encoded) / double(total_num_factors);
         double speed = mb_encoded / enc_seconds;
         double cr = double(bytes_written) / double(bytes_encoded) * 100.0;
-        LOG(INFO) << "["<<name<<"] " << "STATS: AVG " << avg_factor_len << " " << " SPEED = " << speed << "MiB/s" << " CR = " << cr;
+        LOG(INFO) << "["<<name<<"] " << "STATS: AVG " << avg_factor_len << " " << " SPEED = " << speed << "MiB/s" << " CR = " << cr << " TIME = " << enc_seconds << " sec";
 
 
         LOG(INFO) << "["<<name<<"] "  "store blockmap";
         bmap.bit_compress();
-        auto bmap_output_file = col.file_name(hash,block_map_uncompressed<true>::type());
+        auto bmap_output_file = col.file_name(hash,block_map_type());
         sdsl::store_to_file(bmap,bmap_output_file);
     }
 };
@@ -23,7 +23,8 @@
 
 template <class t_list>
 struct interleaved_inverted_index {
-	using size_type = uint64_t;
+	using size_type		 = uint64_t;
+	using mapped_bv_type = sdsl::int_vector_mapper<1, std::ios_base::in>;
 
 	static std::string type() { return "interleaved_inverted_index<" + t_list::type() + ">"; }
 
@@ -40,32 +41,35 @@ struct interleaved_inverted_index {
 		m_meta_data.m_num_lists	= idx.num_lists();
 		m_meta_data.m_num_docs	 = idx.num_docs();
 		m_meta_data.m_num_postings = idx.num_postings();
-		bit_ostream<sdsl::bit_vector> lfs(m_list_data);
-		list_meta_data				  lm;
-		LOG(INFO) << "read and compress doc + freq data interleaved";
-		boost::progress_display pd(idx.num_lists());
-		for (size_t i = 0; i < idx.num_lists(); i++) {
-			auto cur_list = idx[i];
-
-			// create interleaved representation with docs d-gapped
-			tmp_buf[0]  = cur_list.doc_ids[0];
-			tmp_buf[1]  = cur_list.freqs[0];
-			uint32_t Ft = cur_list.freqs[0];
-			for (size_t i = 1; i < cur_list.list_len; i++) {
-				size_t offset		= i * 2;
-				tmp_buf[offset]		= cur_list.doc_ids[i] - cur_list.doc_ids[i - 1];
-				tmp_buf[offset + 1] = cur_list.freqs[i];
-				Ft += cur_list.freqs[i];
-			}
+		{
+			bit_ostream<sdsl::bit_vector> lfs(m_list_data);
+			list_meta_data				  lm;
+			LOG(INFO) << "read and compress doc + freq data interleaved";
+			boost::progress_display pd(idx.num_lists());
+			for (size_t i = 0; i < idx.num_lists(); i++) {
+				const auto& cur_list = idx[i];
+
+				// create interleaved representation with docs d-gapped
+				tmp_buf[0]  = cur_list.doc_ids[0];
+				tmp_buf[1]  = cur_list.freqs[0];
+				uint32_t Ft = cur_list.freqs[0];
+				for (size_t i = 1; i < cur_list.list_len; i++) {
+					size_t offset		= i * 2;
+					tmp_buf[offset]		= cur_list.doc_ids[i] - cur_list.doc_ids[i - 1];
+					tmp_buf[offset + 1] = cur_list.freqs[i];
+					Ft += cur_list.freqs[i];
+				}
 
-			// encode
-			lm.list_len   = cur_list.list_len;
-			lm.doc_offset = lfs.tellp();
-			lm.Ft		  = Ft;
-			t_list::encode(lfs, tmp_buf, lm.list_len * 2, m_meta_data.m_num_docs + Ft);
-			m_meta_data.m_list_data.push_back(lm);
-			++pd;
+				// encode
+				lm.list_len   = cur_list.list_len;
+				lm.doc_offset = lfs.tellp();
+				lm.Ft		  = Ft;
+				t_list::encode(lfs, tmp_buf, lm.list_len * 2, m_meta_data.m_num_docs + Ft);
+				m_meta_data.m_list_data.push_back(lm);
+				++pd;
+			}
 		}
+		m_lists = bit_view(m_list_data);
 		LOG(INFO) << "done creating interleaved inverted index.";
 	}
 
@@ -76,6 +80,7 @@ struct interleaved_inverted_index {
 		std::string output_meta		= collection_dir + "/" + META_NAME;
 		sdsl::store_to_file(m_list_data, output_docfreqs);
 		sdsl::store_to_file(m_meta_data, output_meta);
+		utils::pad_file(output_docfreqs, 64);
 	}
 
 	void read(std::string collection_dir)
@@ -84,6 +89,18 @@ struct interleaved_inverted_index {
 		std::string output_meta		= collection_dir + "/" + META_NAME;
 		sdsl::load_from_file(m_list_data, output_docfreqs);
 		sdsl::load_from_file(m_meta_data, output_meta);
+		m_lists = bit_view(m_list_data);
+	}
+
+	// mmap the list data instead of loading it. opening is near instant and
+	// processes serving the same index share the page cache.
+	void read_mapped(std::string collection_dir)
+	{
+		std::string output_docfreqs = collection_dir + "/" + DOCFREQS_NAME;
+		std::string output_meta		= collection_dir + "/" + META_NAME;
+		m_list_map.reset(new mapped_bv_type(output_docfreqs));
+		sdsl::load_from_file(m_meta_data, output_meta);
+		m_lists = bit_view(*m_list_map);
 	}
 
 	void stats()
@@ -92,21 +109,19 @@ struct interleaved_inverted_index {
 		LOG(INFO) << type() << " NUM DOCS = " << m_meta_data.m_num_docs;
 		LOG(INFO) << type() << " NUM LISTS = " << m_meta_data.m_num_lists;
 		LOG(INFO) << type() << " LIST BPI = "
-				  << double(m_list_data.size()) / double(m_meta_data.m_num_postings);
+				  << double(m_lists.size()) / double(m_meta_data.m_num_postings);
 	}
 
-	list_data operator[](size_type idx) const
+	// decode list idx into caller owned buffers. safe to call concurrently.
+	void decode_into(size_type idx, list_data& ld) const
 	{
-		list_data					 ld;
-		static std::vector<uint32_t> tmp_buf(m_meta_data.m_num_docs * 2);
-
-		const auto& lm = m_meta_data.m_list_data[idx];
+		const auto& lm		= m_meta_data.m_list_data[idx];
+		auto&		tmp_buf = list_scratch::buf(lm.list_len * 2);
 
 		ld.list_len = lm.list_len;
-		ld.doc_ids.resize(ld.list_len + 1024); // overhead needed for FastPFor methods
-		ld.freqs.resize(ld.list_len + 1024);   // overhead needed for FastPFor methods
+		ld.grow(lm.list_len);
 
-		bit_istream<sdsl::bit_vector> listfs(m_list_data);
+		bit_istream<bit_view> listfs(m_lists);
 		listfs.seek(lm.doc_offset);
 		t_list::decode(listfs, tmp_buf, lm.list_len * 2, m_meta_data.m_num_docs + lm.Ft);
 
@@ -118,8 +133,14 @@ struct interleaved_inverted_index {
 			ld.doc_ids[i] = tmp_buf[offset] + ld.doc_ids[i - 1];
 			ld.freqs[i]   = tmp_buf[offset + 1];
 		}
+	}
 
-
+	// decode into the calling thread's scratch buffer. the reference stays
+	// valid until the same thread decodes the next list.
+	list_data& operator[](size_type idx) const
+	{
+		auto& ld = list_scratch::get();
+		decode_into(idx, ld);
 		return ld;
 	}
 
@@ -132,7 +153,7 @@ struct interleaved_inverted_index {
 	size_t list_encoding_bits(size_type idx) const
 	{
 		const auto& lm				= m_meta_data.m_list_data[idx];
-		size_t		next_doc_offset = m_list_data.size();
+		size_t		next_doc_offset = m_lists.size();
 		if (idx + 1 != m_meta_data.m_list_data.size()) {
 			const auto& lm1 = m_meta_data.m_list_data[idx + 1];
 			next_doc_offset = lm1.doc_offset;
@@ -154,9 +175,11 @@ struct interleaved_inverted_index {
 			return true;
 		}
 
+		auto& first  = list_scratch::get(0);
+		auto& second = list_scratch::get(1);
 		for (size_t i = 0; i < num_lists(); i++) {
-			auto first  = (*this)[i];
-			auto second = other[i];
+			decode_into(i, first);
+			other.decode_into(i, second);
 			if (first != second) return true;
 		}
 
@@ -165,87 +188,55 @@ struct interleaved_inverted_index {
 
 	bool verify(std::string input_prefix) const
 	{
-		std::string input_docids = input_prefix + ".docs";
-		std::string input_freqs  = input_prefix + ".freqs";
-		if (!utils::file_exists(input_docids)) {
-			LOG(FATAL) << "input prefix does not contain docids file: " << input_docids;
-			throw std::runtime_error("input prefix does not contain docids file.");
+		d2si_reader input(input_prefix);
+		if (input.num_docs() != m_meta_data.m_num_docs) {
+			LOG(ERROR) << "num docs not equal";
+			return false;
 		}
-		if (!utils::file_exists(input_freqs)) {
-			LOG(FATAL) << "input prefix does not contain freqs file: " << input_freqs;
-			throw std::runtime_error("input prefix does not contain freqs file.");
+		if (input.num_lists() != m_meta_data.m_num_lists) {
+			LOG(ERROR) << "num lists not equal";
+			return false;
 		}
 
-		// read and verify docs
-		{
-			std::ifstream docs_in(input_docids, std::ios::binary);
-			utils::read_uint32(docs_in); // skip the 1
-			uint32_t num_docs = utils::read_uint32(docs_in);
-			if (num_docs != m_meta_data.m_num_docs) {
-				LOG(ERROR) << "num docs not equal";
+		auto   freq_itr  = input.freqs().begin();
+		size_t num_lists = 0;
+		for (const auto& docs : input.docs()) {
+			const auto& freqs = *freq_itr;
+			++freq_itr;
+			auto& lm = m_meta_data.m_list_data[num_lists];
+			if (docs.size() != lm.list_len) {
+				LOG(ERROR) << "list lens not equal";
 				return false;
 			}
-
-			size_t num_lists = 0;
-			while (!docs_in.eof()) {
-				uint32_t list_len = utils::read_uint32(docs_in);
-				if (list_len != m_meta_data.m_list_data[num_lists].list_len) {
-					LOG(ERROR) << "list lens not equal";
+			const auto& cur_list = (*this)[num_lists];
+			uint64_t	Ft		 = 0;
+			for (uint32_t i = 0; i < docs.size(); i++) {
+				if (cur_list.doc_ids[i] != docs[i]) {
+					LOG(ERROR) << "list=" << num_lists << " (llen=" << docs.size()
+							   << ") doc ids not equal i=" << i << " is: " << cur_list.doc_ids[i]
+							   << " should be: " << docs[i];
 					return false;
 				}
-				auto cur_list = (*this)[num_lists];
-
-				for (uint32_t i = 0; i < list_len; i++) {
-					uint32_t cur_id = utils::read_uint32(docs_in);
-					if (cur_list.doc_ids[i] != cur_id) {
-						LOG(ERROR) << "list=" << num_lists << " (llen=" << list_len
-								   << ") doc ids not equal i=" << i
-								   << " is: " << cur_list.doc_ids[i] << " should be: " << cur_id;
-						return false;
-					}
+				if (cur_list.freqs[i] != freqs[i]) {
+					LOG(ERROR) << "freq data in list " << num_lists << " not equal at " << i
+							   << " is(" << cur_list.freqs[i] << ") expected(" << freqs[i] << ")";
+					return false;
 				}
-				num_lists++;
+				Ft += freqs[i];
 			}
-			if (num_lists != m_meta_data.m_num_lists) {
-				LOG(ERROR) << "num lists not equal";
+			if (Ft != lm.Ft) {
+				LOG(ERROR) << "Ft in list " << num_lists << " not equal is(" << Ft << ") expected("
+						   << lm.Ft << ")";
 				return false;
 			}
-		}
-		// read and verify freqs
-		{
-			std::ifstream freqs_in(input_freqs, std::ios::binary);
-			size_t		  num_lists = 0;
-			while (!freqs_in.eof()) {
-				auto&  lm			 = m_meta_data.m_list_data[num_lists];
-				auto   cur_list		 = (*this)[num_lists];
-				size_t freq_list_len = utils::read_uint32(freqs_in);
-				if (freq_list_len != lm.list_len) {
-					LOG(ERROR) << "freq list len not equal";
-					return false;
-				}
-				uint64_t Ft = 0;
-				for (uint32_t i = 0; i < lm.list_len; i++) {
-					uint32_t cur_freq = utils::read_uint32(freqs_in);
-					if (cur_list.freqs[i] != cur_freq) {
-						LOG(ERROR) << "freq data in list " << num_lists << " not equal at " << i
-								   << " is(" << cur_list.freqs[i] << ") expected(" << cur_freq
-								   << ")";
-						return false;
-					}
-					Ft += cur_freq;
-				}
-				if (Ft != lm.Ft) {
-					LOG(ERROR) << "Ft in list " << num_lists << " not equal is(" << Ft
-							   << ") expected(" << lm.Ft << ")";
-					return false;
-				}
-				num_lists++;
-			}
+			num_lists++;
 		}
 
 		return true;
 	}
 
-	meta_data		 m_meta_data;
-	sdsl::bit_vector m_list_data;
+	meta_data						m_meta_data;
+	sdsl::bit_vector				m_list_data;
+	std::unique_ptr<mapped_bv_type> m_list_map;
+	bit_view						m_lists;
 };
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "collection.hpp"
+#include "d2si_reader.hpp"
+#include "list_data.hpp"
 #include "meta_data.hpp"
+#include "storage_chunks.hpp"
 
 #include "bit_coders.hpp"
 #include "bit_streams.hpp"
@@ -19,93 +22,42 @@ struct interleaved_storage_index {
 
   interleaved_storage_index() {}
 
-  // construct index
-  interleaved_storage_index(std::string input_prefix) {
-    std::string input_docids = input_prefix + ".docs";
-    std::string input_freqs = input_prefix + ".freqs";
-    if (!utils::file_exists(input_docids)) {
-      LOG(FATAL) << "input prefix does not contain docids file: "
-                 << input_docids;
-      throw std::runtime_error("input prefix does not contain docids file.");
-    }
-    if (!utils::file_exists(input_freqs)) {
-      LOG(FATAL) << "input prefix does not contain freqs file: " << input_freqs;
-      throw std::runtime_error("input prefix does not contain freqs file.");
-    }
-
-    std::vector<uint32_t> tmp_buf;
-    {
-      std::ifstream docs_in(input_docids, std::ios::binary);
-      utils::read_uint32(docs_in);              // skip the 1
-      m_num_docs = utils::read_uint32(docs_in); // skip num docs
-
-      // allocate some space first
-      size_t file_size = utils::file_size(input_docids);
-
-      LOG(INFO) << "read doc ids";
-
-      boost::progress_display pd(file_size);
-      std::vector<uint32_t> list_lens;
-      pd += sizeof(uint32_t) * 2;
-      m_num_postings = 0;
-      while (!docs_in.eof()) {
-        uint32_t list_len = utils::read_uint32(docs_in);
-        list_lens.push_back(list_len);
-        uint32_t prev = 0;
-        for (uint32_t i = 0; i < list_len; i++) {
-          uint32_t doc_id = utils::read_uint32(docs_in);
-          tmp_buf.push_back(doc_id - prev);
-          tmp_buf.push_back(0); // place holder for the frequency
-          m_num_postings++;
-          prev = doc_id;
-        }
-        pd += sizeof(uint32_t) * (list_len + 1);
-      }
-      LOG(INFO) << "num postings = " << m_num_postings;
-      LOG(INFO) << "num lists = " << list_lens.size();
-
-      LOG(INFO) << "store list lens";
-      m_list_lens.resize(list_lens.size());
-      for (size_t i = 0; i < list_lens.size(); i++)
-        m_list_lens[i] = list_lens[i];
-    }
-
-    {
-      std::ifstream freqs_in(input_freqs, std::ios::binary);
-      size_t file_size = utils::file_size(input_freqs);
-      LOG(INFO) << "read freqs";
-      boost::progress_display pd(file_size);
-      size_t cur_freq_pos = 1;
-      while (!freqs_in.eof()) {
-        uint32_t list_len = utils::read_uint32(freqs_in); // skip list len
-        for (uint32_t i = 0; i < list_len; i++) {
-          uint32_t freq = utils::read_uint32(freqs_in);
-          tmp_buf[cur_freq_pos] = freq;
-          cur_freq_pos += 2;
-        }
-        pd += sizeof(uint32_t) * (list_len + 1);
-      }
-
-      LOG(INFO) << "transform data";
-      sdsl::bit_vector transformed_data;
-      {
-        bit_ostream<sdsl::bit_vector> tfs(transformed_data);
-        tfs.expand_if_needed(file_size);
-        t_transform coder;
-        coder.encode(tfs, tmp_buf.data(), tmp_buf.size());
-        tmp_buf = std::vector<uint32_t>(); // clear the data
-      }
-
-      LOG(INFO) << "compress data";
-      {
-        bit_ostream<sdsl::bit_vector> ffs(m_data);
-        ffs.expand_if_needed(file_size);
-        const uint8_t *data_ptr = (const uint8_t *)transformed_data.data();
-        m_transfromed_data_size = transformed_data.size() / 8;
-        t_compress coder;
-        coder.encode(ffs, data_ptr, m_transfromed_data_size);
+  // construct index. doc gaps and freqs are interleaved and streamed through
+  // the transform and compressor in frames as large as mem_budget bytes
+  // allow on top of the mapped input and the compressed output, capped at
+  // frame_size integers if it is not 0. each frame can be decoded on its own.
+  interleaved_storage_index(
+      std::string input_prefix,
+      uint64_t mem_budget = storage_chunks::default_mem_budget,
+      uint64_t frame_size = storage_chunks::default_frame_size) {
+    d2si_reader input(input_prefix);
+    m_num_docs = input.num_docs();
+    m_num_postings = input.num_postings();
+    frame_size = storage_chunks::frame_size(mem_budget, frame_size);
+    LOG(INFO) << "num postings = " << m_num_postings;
+    LOG(INFO) << "num lists = " << input.num_lists();
+    LOG(INFO) << "frame size = " << frame_size;
+
+    LOG(INFO) << "transform and compress data";
+    storage_chunk_writer<t_transform, t_compress> writer(m_data, frame_size);
+    m_list_lens.resize(input.num_lists());
+    size_t num_lists = 0;
+    auto freq_itr = input.freqs().begin();
+    boost::progress_display pd(input.num_lists());
+    for (const auto &docs : input.docs()) {
+      const auto &freqs = *freq_itr;
+      ++freq_itr;
+      m_list_lens[num_lists++] = docs.size();
+      uint32_t prev = 0;
+      for (size_t i = 0; i < docs.size(); i++) {
+        writer.push_back(docs[i] - prev);
+        writer.push_back(freqs[i]);
+        prev = docs[i];
       }
+      ++pd;
     }
+    m_frames = writer.finish();
+    build_directory();
     LOG(INFO) << "done storing inverted index.";
   }
 
@@ -116,9 +68,9 @@ struct interleaved_storage_index {
     sdsl::store_to_file(m_data, output_docfreqs);
     std::ofstream meta_fs(output_meta);
     sdsl::serialize(m_num_docs, meta_fs);
-    sdsl::serialize(m_transfromed_data_size, meta_fs);
     sdsl::serialize(m_num_postings, meta_fs);
     sdsl::serialize(m_list_lens, meta_fs);
+    sdsl::serialize(m_frames, meta_fs);
   }
 
   void read(std::string collection_dir) {
@@ -128,9 +80,40 @@ struct interleaved_storage_index {
 
     std::ifstream meta_fs(output_meta);
     sdsl::read_member(m_num_docs, meta_fs);
-    sdsl::read_member(m_transfromed_data_size, meta_fs);
     sdsl::read_member(m_num_postings, meta_fs);
     sdsl::load(m_list_lens, meta_fs);
+    sdsl::load(m_frames, meta_fs);
+    build_directory();
+  }
+
+  size_type num_docs() const { return m_num_docs; }
+  size_type num_lists() const { return m_list_lens.size(); }
+  size_type num_postings() const { return m_num_postings; }
+  size_type list_len(size_type idx) const { return m_list_lens[idx]; }
+
+  // decode a single list. only the frames the list spans are decompressed.
+  void decode_into(size_type idx, list_data &ld) const {
+    static thread_local std::vector<uint32_t> tmp;
+    storage_chunk_reader<t_transform, t_compress> data_in(m_data, m_frames,
+                                                          2 * m_num_postings);
+    ld.list_len = m_list_lens[idx];
+    ld.grow(ld.list_len);
+    if (tmp.size() < 2 * ld.list_len)
+      tmp.resize(2 * ld.list_len);
+    data_in.decode(2 * m_list_starts[idx], 2 * ld.list_len, tmp.data());
+    for (size_t i = 0; i < ld.list_len; i++) {
+      ld.doc_ids[i] = tmp[2 * i];
+      ld.freqs[i] = tmp[2 * i + 1];
+    }
+    utils::prefix_sum(ld.doc_ids.data(), ld.list_len);
+  }
+
+  // decode into the calling thread's scratch buffer. the reference stays
+  // valid until the same thread decodes the next list.
+  list_data &operator[](size_type idx) const {
+    auto &ld = list_scratch::get();
+    decode_into(idx, ld);
+    return ld;
   }
 
   void stats() {
@@ -140,105 +123,62 @@ struct interleaved_storage_index {
   }
 
   bool verify(std::string input_prefix) const {
-    std::string input_docids = input_prefix + ".docs";
-    std::string input_freqs = input_prefix + ".freqs";
-    if (!utils::file_exists(input_docids)) {
-      LOG(FATAL) << "input prefix does not contain docids file: "
-                 << input_docids;
-      throw std::runtime_error("input prefix does not contain docids file.");
+    d2si_reader input(input_prefix);
+    if (input.num_lists() != m_list_lens.size()) {
+      LOG(ERROR) << "num lists not equal";
+      return false;
     }
-    if (!utils::file_exists(input_freqs)) {
-      LOG(FATAL) << "input prefix does not contain freqs file: " << input_freqs;
-      throw std::runtime_error("input prefix does not contain freqs file.");
-    }
-
-    // (1) reconstruct data
-    std::vector<uint32_t> postings_data((2 * m_num_postings) + 1024);
-    {
-      bit_istream<sdsl::bit_vector> datafs(m_data);
-      sdsl::bit_vector transformed_data(1024 + m_transfromed_data_size * 8);
-      uint8_t *data_ptr = (uint8_t *)transformed_data.data();
-      t_compress decoder;
-      LOG(INFO) << "reversing compression";
-      decoder.decode(datafs, data_ptr, m_transfromed_data_size);
-
-      bit_istream<sdsl::bit_vector> tfs(transformed_data);
-      t_transform coder;
-      LOG(INFO) << "reversing transform";
-      coder.decode(tfs, postings_data.data(), m_num_postings * 2);
+    if (input.num_docs() != m_num_docs) {
+      LOG(ERROR) << "num docs not equal";
+      return false;
     }
 
-    // (2) read and verify docs
-    {
-      LOG(INFO) << "read and verify docs";
-      std::ifstream docs_in(input_docids, std::ios::binary);
-      utils::read_uint32(docs_in); // skip the 1
-      uint32_t num_docs = utils::read_uint32(docs_in);
-      if (num_docs != m_num_docs) {
-        LOG(ERROR) << "num docs not equal";
+    // read and verify docs and freqs
+    LOG(INFO) << "read and verify docs and freqs";
+    size_t num_lists = 0;
+    auto freq_itr = input.freqs().begin();
+    for (const auto &docs : input.docs()) {
+      const auto &freqs = *freq_itr;
+      ++freq_itr;
+      if (docs.size() != m_list_lens[num_lists]) {
+        LOG(ERROR) << "list lens not equal";
         return false;
       }
-
-      size_t num_lists = 0;
-      size_t num_postings = 0;
-      while (!docs_in.eof()) {
-        uint32_t list_len = utils::read_uint32(docs_in);
-        if (list_len != m_list_lens[num_lists]) {
-          LOG(ERROR) << "list lens not equal";
+      const auto &cur_list = (*this)[num_lists];
+      for (uint32_t i = 0; i < docs.size(); i++) {
+        if (cur_list.doc_ids[i] != docs[i]) {
+          LOG(ERROR) << "list=" << num_lists << " (llen=" << docs.size()
+                     << ") doc ids not equal i=" << i
+                     << " is: " << cur_list.doc_ids[i]
+                     << " should be: " << docs[i];
           return false;
         }
-
-        size_t prev = 0;
-        for (uint32_t i = 0; i < list_len; i++) {
-          uint32_t cur_id = utils::read_uint32(docs_in);
-          uint32_t recovered_id = postings_data[num_postings] + prev;
-          num_postings += 2;
-          prev = recovered_id;
-          if (recovered_id != cur_id) {
-            LOG(ERROR) << "list=" << num_lists << " (llen=" << list_len
-                       << ") doc ids not equal i=" << i
-                       << " is: " << recovered_id << " should be: " << cur_id;
-            return false;
-          }
-        }
-        num_lists++;
-      }
-      if (num_lists != m_list_lens.size()) {
-        LOG(ERROR) << "num lists not equal";
-        return false;
-      }
-    }
-
-    // read and verify freqs
-    {
-      LOG(INFO) << "read and verify freqs";
-      std::ifstream freqs_in(input_freqs, std::ios::binary);
-      size_t num_lists = 0;
-      size_t num_postings = 1;
-      while (!freqs_in.eof()) {
-        size_t freq_list_len = utils::read_uint32(freqs_in);
-        if (freq_list_len != m_list_lens[num_lists]) {
-          LOG(ERROR) << "freq list len not equal";
+        if (cur_list.freqs[i] != freqs[i]) {
+          LOG(ERROR) << "freq data not equal";
           return false;
         }
-        for (uint32_t i = 0; i < freq_list_len; i++) {
-          uint32_t cur_freq = utils::read_uint32(freqs_in);
-          uint32_t recovered_freq = postings_data[num_postings];
-          num_postings += 2;
-          if (recovered_freq != cur_freq) {
-            LOG(ERROR) << "freq data not equal";
-            return false;
-          }
-        }
-        num_lists++;
       }
+      num_lists++;
     }
     return true;
   }
 
+  // first posting of every list, the list starts at twice that integer of
+  // the interleaved stream
+  void build_directory() {
+    m_list_starts.resize(m_list_lens.size());
+    uint64_t start = 0;
+    for (size_t i = 0; i < m_list_lens.size(); i++) {
+      m_list_starts[i] = start;
+      start += m_list_lens[i];
+    }
+    sdsl::util::bit_compress(m_list_starts);
+  }
+
   uint64_t m_num_docs;
-  uint64_t m_transfromed_data_size;
   uint64_t m_num_postings;
   sdsl::int_vector<32> m_list_lens;
+  sdsl::int_vector<> m_list_starts;
+  storage_frames m_frames;
   sdsl::bit_vector m_data;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "collection.hpp"
+#include "d2si_reader.hpp"
 #include "meta_data.hpp"
 
 #include "bit_coders.hpp"
@@ -10,6 +11,7 @@
 #include "list_simple16.hpp"
 #include "list_op4.hpp"
 #include "list_ef.hpp"
+#include "list_pef.hpp"
 #include "list_interp.hpp"
 #include "list_interp_block.hpp"
 #include "list_u32.hpp"
@@ -18,45 +20,29 @@
 #include "list_s16_lz.hpp"
 #include "list_s16_vblz.hpp"
 #include "list_qmx.hpp"
+#include "list_simd.hpp"
+#include "list_adaptive.hpp"
+#include "list_rans.hpp"
+#include "list_vbyte_zdict.hpp"
+#include "list_rlz.hpp"
+#include "list_dictionary.hpp"
+#include "list_skip.hpp"
+#include "list_cursor.hpp"
+#include "list_data.hpp"
+#include "rankers.hpp"
 
 #include "boost/progress.hpp"
 
-struct list_data {
-	size_t				  list_len;
-	std::vector<uint32_t> doc_ids;
-	std::vector<uint32_t> freqs;
-
-	list_data(size_t n)
-	{
-		doc_ids.resize(n + 1024);
-		freqs.resize(n + 1024);
-	}
-
-	bool operator!=(const list_data& other) const
-	{
-		if (list_len != other.list_len) {
-			LOG(ERROR) << "list len not equal";
-			return true;
-		}
-
-		for (size_t i = 0; i < list_len; i++) {
-			if (doc_ids[i] != other.doc_ids[i]) {
-				LOG(ERROR) << "doc id data not equal";
-				return true;
-			}
-			if (freqs[i] != other.freqs[i]) {
-				LOG(ERROR) << "freq data not equal";
-				return true;
-			}
-		}
-
-		return false;
-	}
-};
+#include <future>
+#include <memory>
+#include <thread>
 
 template <class t_doc_list, class t_freq_list>
 struct inverted_index {
-	using size_type = uint64_t;
+	using size_type		 = uint64_t;
+	using mapped_bv_type = sdsl::int_vector_mapper<1, std::ios_base::in>;
+	using doc_dict_type  = typename list_dictionary<t_doc_list>::state_type;
+	using freq_dict_type = typename list_dictionary<t_freq_list>::state_type;
 
 	static std::string type()
 	{
@@ -65,81 +51,201 @@ struct inverted_index {
 
 	inverted_index() {}
 
-	// construct index
-	inverted_index(std::string input_prefix)
+	// construct index. lists are handed out in batches which a pool of
+	// num_threads encoders compress into private streams while the next
+	// batches are prepared. the encoded batches are then appended to the
+	// index in input order.
+	inverted_index(std::string input_prefix, size_t num_threads = std::thread::hardware_concurrency())
 	{
-		std::string input_docids = input_prefix + ".docs";
-		std::string input_freqs  = input_prefix + ".freqs";
-		if (!utils::file_exists(input_docids)) {
-			LOG(FATAL) << "input prefix does not contain docids file: " << input_docids;
-			throw std::runtime_error("input prefix does not contain docids file.");
-		}
-		if (!utils::file_exists(input_freqs)) {
-			LOG(FATAL) << "input prefix does not contain freqs file: " << input_freqs;
-			throw std::runtime_error("input prefix does not contain freqs file.");
-		}
+		d2si_reader input(input_prefix);
+		num_threads = std::max(num_threads, size_t(1));
 
-		{
-			LOG(INFO) << "read and compress doc ids";
-			std::ifstream docs_in(input_docids, std::ios::binary);
-			utils::read_uint32(docs_in); // skip the 1
-			m_meta_data.m_num_docs = utils::read_uint32(docs_in);
+		LOG(INFO) << "read and compress doc ids and freqs (" << num_threads << " threads)";
+		m_meta_data.m_num_docs = input.num_docs();
+		m_meta_data.m_list_data.reserve(input.num_lists());
+		m_doc_lens = sdsl::int_vector<32>(m_meta_data.m_num_docs, 0);
+		list_dictionary<t_doc_list>::train(*m_doc_dict, input.docs());
+		list_dictionary<t_freq_list>::train(*m_freq_dict, input.freqs());
 
+		{
 			bit_ostream<sdsl::bit_vector> ofs(m_doc_data);
+			bit_ostream<sdsl::bit_vector> ffs(m_freq_data);
 
 			// allocate some space first
-			size_t file_size = utils::file_size(input_docids);
-			ofs.expand_if_needed(file_size / 11); // 3 bits per elem
-
-			std::vector<uint32_t>   buf(m_meta_data.m_num_docs);
-			list_meta_data			lm;
-			size_t					num_lists = 0;
-			boost::progress_display pd(file_size);
-			pd += sizeof(uint32_t) * 2;
-			while (!docs_in.eof()) {
-				lm.list_len = utils::read_uint32(docs_in);
-				for (uint32_t i = 0; i < lm.list_len; i++) {
-					buf[i] = utils::read_uint32(docs_in);
-					m_meta_data.m_num_postings++;
+			ofs.expand_if_needed(input.num_postings() * 3); // 3 bits per elem
+			ffs.expand_if_needed(input.num_postings() * 2); // 2 bits per elem
+			list_dictionary<t_doc_list>::write(ofs, *m_doc_dict);
+			list_dictionary<t_freq_list>::write(ffs, *m_freq_dict);
+
+			boost::progress_display pd(input.num_postings());
+			auto					doc_itr  = input.docs().begin();
+			auto					freq_itr = input.freqs().begin();
+			auto					read_round = [&]() {
+				   std::vector<build_batch> round;
+				   for (size_t i = 0; i < num_threads && doc_itr != input.docs().end(); i++) {
+					   round.emplace_back();
+					   read_batch(doc_itr, freq_itr, input.docs().end(), round.back());
+					   pd += round.back().num_postings;
+				   }
+				   return round;
+			};
+
+			size_t				  num_docs  = m_meta_data.m_num_docs;
+			const doc_dict_type*  doc_dict  = m_doc_dict.get();
+			const freq_dict_type* freq_dict = m_freq_dict.get();
+			auto				  round		= read_round();
+			while (!round.empty()) {
+				std::vector<std::future<void>> fis;
+				for (auto& batch : round) {
+					build_batch* b = &batch;
+					fis.push_back(
+					std::async(std::launch::async, [b, num_docs, doc_dict, freq_dict] {
+						encode_batch(*b, num_docs, *doc_dict, *freq_dict);
+					}));
+				}
+				auto next = read_round();
+				// join the encoders and stitch their output together. codecs align
+				// relative to the stream start so each batch starts on 128 bits.
+				for (size_t i = 0; i < round.size(); i++) {
+					fis[i].get();
+					auto& batch = round[i];
+					ofs.align128();
+					ffs.align128();
+					uint64_t doc_start  = ofs.tellp();
+					uint64_t freq_start = ffs.tellp();
+					for (size_t j = 0; j < batch.docs.size(); j++) {
+						auto& lm	   = m_meta_data.m_list_data[batch.first_list + j];
+						lm.doc_offset  = doc_start + batch.doc_offsets[j];
+						lm.freq_offset = freq_start + batch.freq_offsets[j];
+					}
+					ofs.append(batch.doc_data);
+					ffs.append(batch.freq_data);
 				}
-				num_lists++;
-				lm.doc_offset = ofs.tellp();
-				t_doc_list::encode(ofs, buf, lm.list_len, m_meta_data.m_num_docs);
-				m_meta_data.m_list_data.push_back(lm);
-				pd += sizeof(uint32_t) * (lm.list_len + 1);
+				round = std::move(next);
 			}
-			m_meta_data.m_num_lists = num_lists;
 		}
-		{
-			LOG(INFO) << "read and compress freqs";
-			std::ifstream				  freqs_in(input_freqs, std::ios::binary);
-			bit_ostream<sdsl::bit_vector> ffs(m_freq_data);
+		m_meta_data.m_num_lists = m_meta_data.m_list_data.size();
 
-			// allocate some space first
-			size_t file_size = utils::file_size(input_freqs);
-			ffs.expand_if_needed(file_size / 16); // 2 bits per elem
-
-			std::vector<uint32_t>   buf(m_meta_data.m_num_docs);
-			size_t					num_lists = 0;
-			boost::progress_display pd(file_size);
-			while (!freqs_in.eof()) {
-				auto&  lm			 = m_meta_data.m_list_data[num_lists];
-				size_t freq_list_len = utils::read_uint32(freqs_in);
-				if (freq_list_len != lm.list_len) {
-					LOG(ERROR) << "freq and doc_id lists not same len";
-				}
-				lm.Ft = 0;
-				for (uint32_t i = 0; i < lm.list_len; i++) {
-					buf[i] = utils::read_uint32(freqs_in);
-					lm.Ft += buf[i];
+		m_docs  = bit_view(m_doc_data);
+		m_freqs = bit_view(m_freq_data);
+		compute_score_bounds();
+		LOG(INFO) << "done creating inverted index.";
+	}
+
+	// consecutive lists of the mapped input and, once encoded, their private
+	// streams
+	struct build_batch {
+		size_t				   first_list   = 0;
+		size_t				   num_postings = 0;
+		std::vector<d2si_list> docs;
+		std::vector<d2si_list> freqs;
+		std::vector<uint64_t>  fts;
+		sdsl::bit_vector	   doc_data;
+		sdsl::bit_vector	   freq_data;
+		std::vector<uint64_t>  doc_offsets;
+		std::vector<uint64_t>  freq_offsets;
+	};
+
+	// take lists until the batch holds about batch_postings postings. list
+	// meta data and document lengths are filled in here, in input order.
+	void read_batch(d2si_lists::iterator& doc_itr, d2si_lists::iterator& freq_itr,
+	d2si_lists::iterator doc_end, build_batch& batch)
+	{
+		const size_t batch_postings = 1ULL << 20;
+		batch.first_list			= m_meta_data.m_list_data.size();
+		while (batch.num_postings < batch_postings && doc_itr != doc_end) {
+			auto		   docs  = *doc_itr;
+			auto		   freqs = *freq_itr;
+			list_meta_data lm;
+			lm.list_len = docs.size();
+			lm.Ft		= 0;
+			for (uint32_t i = 0; i < lm.list_len; i++) {
+				if (docs[i] < m_doc_lens.size()) m_doc_lens[docs[i]] = m_doc_lens[docs[i]] + freqs[i];
+				lm.Ft += freqs[i];
+			}
+			m_meta_data.m_num_postings += lm.list_len;
+			m_meta_data.m_list_data.push_back(lm);
+			batch.num_postings += lm.list_len;
+			batch.docs.push_back(docs);
+			batch.freqs.push_back(freqs);
+			batch.fts.push_back(lm.Ft);
+			++doc_itr;
+			++freq_itr;
+		}
+	}
+
+	// runs on an encoder thread. offsets are relative to the batch streams.
+	static void encode_batch(build_batch& batch, size_t num_docs, const doc_dict_type& doc_dict,
+	const freq_dict_type& freq_dict)
+	{
+		bit_ostream<sdsl::bit_vector> ofs(batch.doc_data);
+		bit_ostream<sdsl::bit_vector> ffs(batch.freq_data);
+		for (size_t j = 0; j < batch.docs.size(); j++) {
+			size_t n   = batch.docs[j].size();
+			auto&  buf = list_scratch::buf(n);
+			std::copy(batch.docs[j].begin(), batch.docs[j].end(), buf.begin());
+			batch.doc_offsets.push_back(ofs.tellp());
+			list_dictionary<t_doc_list>::encode(doc_dict, ofs, buf, n, num_docs);
+			std::copy(batch.freqs[j].begin(), batch.freqs[j].end(), buf.begin());
+			batch.freq_offsets.push_back(ffs.tellp());
+			list_dictionary<t_freq_list>::encode(freq_dict, ffs, buf, n, batch.fts[j]);
+		}
+	}
+
+	// store the highest bm25 score of each list in its meta data and the
+	// highest tf and score of each block in m_block_max. list bounds are
+	// rounded up to the next float so they never drop below an actual score.
+	void compute_score_bounds()
+	{
+		LOG(INFO) << "compute bm25 upper bounds";
+		uint64_t total_len = 0;
+		for (auto len : m_doc_lens)
+			total_len += len;
+		m_meta_data.m_avg_doc_len = double(total_len) / double(m_meta_data.m_num_docs);
+
+		m_block_max.m_block_size = list_skip_block_size<t_doc_list>::value;
+		m_block_max.m_block_start.resize(m_meta_data.m_num_lists + 1);
+		size_t total_blocks = 0;
+		for (size_t i = 0; i < m_meta_data.m_num_lists; i++) {
+			m_block_max.m_block_start[i] = total_blocks;
+			total_blocks += m_block_max.num_blocks(m_meta_data.m_list_data[i].list_len);
+		}
+		m_block_max.m_block_start[m_meta_data.m_num_lists] = total_blocks;
+		m_block_max.m_max_tf	 = sdsl::int_vector<>(total_blocks, 0);
+		m_block_max.m_max_impact = sdsl::int_vector<8>(total_blocks, 0);
+
+		auto&				ld = list_scratch::get();
+		std::vector<double> block_scores;
+		for (size_t i = 0; i < m_meta_data.m_num_lists; i++) {
+			auto& lm = m_meta_data.m_list_data[i];
+			decode_into(i, ld);
+			size_t num_blocks = m_block_max.num_blocks(lm.list_len);
+			size_t block_size = num_blocks == 1 ? lm.list_len : m_block_max.m_block_size;
+			size_t first	  = m_block_max.m_block_start[i];
+			block_scores.assign(num_blocks, 0);
+			double idf		 = bm25::idf(m_meta_data.m_num_docs, lm.list_len);
+			double max_score = 0;
+			for (size_t j = 0; j < ld.list_len; j++) {
+				if (ld.doc_ids[j] >= m_doc_lens.size()) continue;
+				double score = bm25::score(idf, ld.freqs[j], m_doc_lens[ld.doc_ids[j]],
+				m_meta_data.m_avg_doc_len);
+				size_t b = j / block_size;
+				block_scores[b] = std::max(block_scores[b], score);
+				if (ld.freqs[j] > m_block_max.m_max_tf[first + b]) {
+					m_block_max.m_max_tf[first + b] = ld.freqs[j];
 				}
-				num_lists++;
-				lm.freq_offset = ffs.tellp();
-				t_freq_list::encode(ffs, buf, lm.list_len, lm.Ft);
-				pd += sizeof(uint32_t) * (lm.list_len + 1);
+				max_score = std::max(max_score, score);
+			}
+			lm.max_score = std::nextafter(float(max_score), std::numeric_limits<float>::max());
+			for (size_t b = 0; b < num_blocks; b++) {
+				uint64_t q = std::ceil(block_scores[b] * 255.0 / lm.max_score);
+				while (q < 255 && q * double(lm.max_score) / 255.0 < block_scores[b])
+					q++;
+				m_block_max.m_max_impact[first + b] = std::min(q, uint64_t(255));
 			}
 		}
-		LOG(INFO) << "done creating inverted index.";
+		sdsl::util::bit_compress(m_block_max.m_block_start);
+		sdsl::util::bit_compress(m_block_max.m_max_tf);
 	}
 
 	void write(std::string collection_dir)
@@ -151,6 +257,10 @@ struct inverted_index {
 		sdsl::store_to_file(m_doc_data, output_docids);
 		sdsl::store_to_file(m_freq_data, output_freqs);
 		sdsl::store_to_file(m_meta_data, output_meta);
+		sdsl::store_to_file(m_doc_lens, collection_dir + "/" + DOCLENS_NAME);
+		sdsl::store_to_file(m_block_max, collection_dir + "/" + BLOCKMAX_NAME);
+		utils::pad_file(output_docids, 64);
+		utils::pad_file(output_freqs, 64);
 	}
 
 	void read(std::string collection_dir)
@@ -161,6 +271,37 @@ struct inverted_index {
 		sdsl::load_from_file(m_doc_data, output_docids);
 		sdsl::load_from_file(m_freq_data, output_freqs);
 		sdsl::load_from_file(m_meta_data, output_meta);
+		sdsl::load_from_file(m_doc_lens, collection_dir + "/" + DOCLENS_NAME);
+		sdsl::load_from_file(m_block_max, collection_dir + "/" + BLOCKMAX_NAME);
+		m_docs  = bit_view(m_doc_data);
+		m_freqs = bit_view(m_freq_data);
+		read_dictionaries();
+	}
+
+	// mmap the list data instead of loading it. opening is near instant and
+	// processes serving the same index share the page cache.
+	void read_mapped(std::string collection_dir)
+	{
+		std::string output_docids = collection_dir + "/" + DOCS_NAME;
+		std::string output_freqs  = collection_dir + "/" + FREQS_NAME;
+		std::string output_meta   = collection_dir + "/" + META_NAME;
+		m_doc_map.reset(new mapped_bv_type(output_docids));
+		m_freq_map.reset(new mapped_bv_type(output_freqs));
+		sdsl::load_from_file(m_meta_data, output_meta);
+		sdsl::load_from_file(m_doc_lens, collection_dir + "/" + DOCLENS_NAME);
+		sdsl::load_from_file(m_block_max, collection_dir + "/" + BLOCKMAX_NAME);
+		m_docs  = bit_view(*m_doc_map);
+		m_freqs = bit_view(*m_freq_map);
+		read_dictionaries();
+	}
+
+	// lists sharing a dictionary find it at the start of their stream
+	void read_dictionaries()
+	{
+		bit_istream<bit_view> docfs(m_docs);
+		list_dictionary<t_doc_list>::read(docfs, *m_doc_dict);
+		bit_istream<bit_view> freqfs(m_freqs);
+		list_dictionary<t_freq_list>::read(freqfs, *m_freq_dict);
 	}
 
 	void stats()
@@ -169,33 +310,53 @@ struct inverted_index {
 		LOG(INFO) << type() << " NUM DOCS = " << m_meta_data.m_num_docs;
 		LOG(INFO) << type() << " NUM LISTS = " << m_meta_data.m_num_lists;
 		LOG(INFO) << type() << " DOC BPI = "
-				  << double(m_doc_data.size()) / double(m_meta_data.m_num_postings);
+				  << double(m_docs.size()) / double(m_meta_data.m_num_postings);
 		LOG(INFO) << type() << " FREQ BPI = "
-				  << double(m_freq_data.size()) / double(m_meta_data.m_num_postings);
+				  << double(m_freqs.size()) / double(m_meta_data.m_num_postings);
 	}
 
-	list_data& operator[](size_type idx) const
+	// decode only the doc ids of list idx. enough for boolean queries.
+	void decode_docs_into(size_type idx, list_data& ld) const
 	{
-		static list_data ld(m_meta_data.m_num_docs);
-
 		const auto& lm = m_meta_data.m_list_data[idx];
 
 		ld.list_len = lm.list_len;
-		// ld.doc_ids.resize(ld.list_len + 1024); // overhead needed for FastPFor methods
-		// ld.freqs.resize(ld.list_len + 1024);   // overhead needed for FastPFor methods
+		ld.grow(lm.list_len);
 
-		bit_istream<sdsl::bit_vector> docfs(m_doc_data);
+		bit_istream<bit_view> docfs(m_docs);
 		docfs.seek(lm.doc_offset);
-		t_doc_list::decode(docfs, ld.doc_ids, lm.list_len, m_meta_data.m_num_docs);
+		list_dictionary<t_doc_list>::decode(*m_doc_dict, docfs, ld.doc_ids, lm.list_len, m_meta_data.m_num_docs);
+	}
 
-		bit_istream<sdsl::bit_vector> freqfs(m_freq_data);
-		freqfs.seek(lm.freq_offset);
-		t_freq_list::decode(freqfs, ld.freqs, lm.list_len, lm.Ft);
+	// decode list idx into caller owned buffers. safe to call concurrently.
+	void decode_into(size_type idx, list_data& ld) const
+	{
+		const auto& lm = m_meta_data.m_list_data[idx];
+		decode_docs_into(idx, ld);
 
+		bit_istream<bit_view> freqfs(m_freqs);
+		freqfs.seek(lm.freq_offset);
+		list_dictionary<t_freq_list>::decode(*m_freq_dict, freqfs, ld.freqs, lm.list_len, lm.Ft);
+	}
 
+	// decode into the calling thread's scratch buffer. the reference stays
+	// valid until the same thread decodes the next list.
+	list_data& operator[](size_type idx) const
+	{
+		auto& ld = list_scratch::get();
+		decode_into(idx, ld);
 		return ld;
 	}
 
+	// forward cursor over list idx supporting next_geq(). if the doc list has a
+	// skip table only the blocks actually visited are decoded.
+	list_cursor<t_doc_list, t_freq_list> cursor(size_type idx) const
+	{
+		const auto& lm = m_meta_data.m_list_data[idx];
+		return list_cursor<t_doc_list, t_freq_list>(m_docs, m_freqs, lm, m_meta_data.m_num_docs,
+		m_doc_dict.get(), m_freq_dict.get());
+	}
+
 	size_t list_len(size_type idx) const
 	{
 		const auto& lm = m_meta_data.m_list_data[idx];
@@ -205,8 +366,8 @@ struct inverted_index {
 	size_t list_encoding_bits(size_type idx) const
 	{
 		const auto& lm				 = m_meta_data.m_list_data[idx];
-		size_t		next_doc_offset  = m_doc_data.size();
-		size_t		next_freq_offset = m_freq_data.size();
+		size_t		next_doc_offset  = m_docs.size();
+		size_t		next_freq_offset = m_freqs.size();
 		if (idx + 1 != m_meta_data.m_list_data.size()) {
 			const auto& lm1  = m_meta_data.m_list_data[idx + 1];
 			next_doc_offset  = lm1.doc_offset;
@@ -219,6 +380,29 @@ struct inverted_index {
 
 	size_type num_lists() const { return m_meta_data.m_num_lists; }
 
+	float max_score(size_type idx) const { return m_meta_data.m_list_data[idx].max_score; }
+
+	uint32_t doc_len(uint32_t id) const { return m_doc_lens[id]; }
+
+	double avg_doc_len() const { return m_meta_data.m_avg_doc_len; }
+
+	// upper bound of the bm25 scores in block b of list idx, using the same
+	// block numbering as the list cursor
+	double block_max_score(size_type idx, size_t b) const
+	{
+		const auto& lm	= m_meta_data.m_list_data[idx];
+		size_t		first = m_block_max.m_block_start[idx];
+		size_t		num   = m_block_max.m_block_start[idx + 1] - first;
+		if (num == 1) return lm.max_score;
+		if (b >= num) return 0;
+		return m_block_max.m_max_impact[first + b] * double(lm.max_score) / 255.0;
+	}
+
+	uint32_t block_max_tf(size_type idx, size_t b) const
+	{
+		return m_block_max.m_max_tf[m_block_max.m_block_start[idx] + b];
+	}
+
 	size_type num_docs() const { return m_meta_data.m_num_docs; }
 
 	size_type num_postings() const { return m_meta_data.m_num_postings; }
@@ -230,9 +414,11 @@ struct inverted_index {
 			return true;
 		}
 
+		auto& first  = list_scratch::get(0);
+		auto& second = list_scratch::get(1);
 		for (size_t i = 0; i < num_lists(); i++) {
-			auto first  = (*this)[i];
-			auto second = other[i];
+			decode_into(i, first);
+			other.decode_into(i, second);
 			if (first != second) return true;
 		}
 
@@ -241,82 +427,57 @@ struct inverted_index {
 
 	bool verify(std::string input_prefix) const
 	{
-		std::string input_docids = input_prefix + ".docs";
-		std::string input_freqs  = input_prefix + ".freqs";
-		if (!utils::file_exists(input_docids)) {
-			LOG(FATAL) << "input prefix does not contain docids file: " << input_docids;
-			throw std::runtime_error("input prefix does not contain docids file.");
+		d2si_reader input(input_prefix);
+		if (input.num_docs() != m_meta_data.m_num_docs) {
+			LOG(ERROR) << "num docs not equal";
+			return false;
 		}
-		if (!utils::file_exists(input_freqs)) {
-			LOG(FATAL) << "input prefix does not contain freqs file: " << input_freqs;
-			throw std::runtime_error("input prefix does not contain freqs file.");
+		if (input.num_lists() != m_meta_data.m_num_lists) {
+			LOG(ERROR) << "num lists not equal";
+			return false;
 		}
 
-		// read and verify docs
-		{
-			std::ifstream docs_in(input_docids, std::ios::binary);
-			utils::read_uint32(docs_in); // skip the 1
-			uint32_t num_docs = utils::read_uint32(docs_in);
-			if (num_docs != m_meta_data.m_num_docs) {
-				LOG(ERROR) << "num docs not equal";
+		auto   freq_itr  = input.freqs().begin();
+		size_t num_lists = 0;
+		for (const auto& docs : input.docs()) {
+			const auto& freqs = *freq_itr;
+			++freq_itr;
+			auto& lm = m_meta_data.m_list_data[num_lists];
+			if (docs.size() != lm.list_len) {
+				LOG(ERROR) << "list lens not equal";
 				return false;
 			}
-
-			size_t num_lists = 0;
-			while (!docs_in.eof()) {
-				uint32_t list_len = utils::read_uint32(docs_in);
-				if (list_len != m_meta_data.m_list_data[num_lists].list_len) {
-					LOG(ERROR) << "list lens not equal";
+			const auto& cur_list = (*this)[num_lists];
+			uint64_t	Ft		 = 0;
+			for (uint32_t i = 0; i < docs.size(); i++) {
+				if (cur_list.doc_ids[i] != docs[i]) {
+					LOG(ERROR) << "list=" << num_lists << " (llen=" << docs.size()
+							   << ") doc ids not equal i=" << i << " is: " << cur_list.doc_ids[i]
+							   << " should be: " << docs[i];
 					return false;
 				}
-				const auto& cur_list = (*this)[num_lists];
-
-				for (uint32_t i = 0; i < list_len; i++) {
-					uint32_t cur_id = utils::read_uint32(docs_in);
-					if (cur_list.doc_ids[i] != cur_id) {
-						LOG(ERROR) << "list=" << num_lists << " (llen=" << list_len
-								   << ") doc ids not equal i=" << i
-								   << " is: " << cur_list.doc_ids[i] << " should be: " << cur_id;
-						return false;
-					}
-				}
-				num_lists++;
-			}
-			if (num_lists != m_meta_data.m_num_lists) {
-				LOG(ERROR) << "num lists not equal";
-				return false;
-			}
-		}
-		// read and verify freqs
-		{
-			std::ifstream freqs_in(input_freqs, std::ios::binary);
-			size_t		  num_lists = 0;
-			while (!freqs_in.eof()) {
-				auto&		lm			  = m_meta_data.m_list_data[num_lists];
-				const auto& cur_list	  = (*this)[num_lists];
-				size_t		freq_list_len = utils::read_uint32(freqs_in);
-				if (freq_list_len != lm.list_len) {
-					LOG(ERROR) << "freq list len not equal";
+				if (cur_list.freqs[i] != freqs[i]) {
+					LOG(ERROR) << "freq data not equal";
 					return false;
 				}
-				uint64_t Ft = 0;
-				for (uint32_t i = 0; i < lm.list_len; i++) {
-					uint32_t cur_freq = utils::read_uint32(freqs_in);
-					if (cur_list.freqs[i] != cur_freq) {
-						LOG(ERROR) << "freq data not equal";
-						return false;
-					}
-					Ft += cur_freq;
-				}
-				if (Ft != lm.Ft) return false;
-				num_lists++;
+				Ft += freqs[i];
 			}
+			if (Ft != lm.Ft) return false;
+			num_lists++;
 		}
 
 		return true;
 	}
 
-	meta_data		 m_meta_data;
-	sdsl::bit_vector m_doc_data;
-	sdsl::bit_vector m_freq_data;
+	meta_data						m_meta_data;
+	sdsl::int_vector<32>			m_doc_lens;
+	block_max_data					m_block_max;
+	sdsl::bit_vector				m_doc_data;
+	sdsl::bit_vector				m_freq_data;
+	std::unique_ptr<mapped_bv_type> m_doc_map;
+	std::unique_ptr<mapped_bv_type> m_freq_map;
+	bit_view						m_docs;
+	bit_view						m_freqs;
+	std::unique_ptr<doc_dict_type>  m_doc_dict{new doc_dict_type()};
+	std::unique_ptr<freq_dict_type> m_freq_dict{new freq_dict_type()};
 };
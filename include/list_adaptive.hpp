@@ -0,0 +1,170 @@
+#pragma once
+
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+
+#include "list_vbyte.hpp"
+#include "list_op4.hpp"
+#include "list_qmx.hpp"
+#include "list_ef.hpp"
+#include "list_interp.hpp"
+#include "list_simple16.hpp"
+
+#include <limits>
+#include <tuple>
+
+// the codec of a list is picked when the list is encoded: every candidate
+// encodes the list and the one minimizing
+//
+//   bits + lambda * estimated decode time in ns
+//
+// wins. lambda = 0 picks the smallest encoding, larger values trade space
+// for decoding speed. lambda is part of the list type, so an index always
+// reads back under the type and name it was built with. the winner's tag is
+// written in front of the list so decoding dispatches per list without any
+// other meta data.
+namespace adaptive {
+
+// rough decode cost of the candidates in ns per integer, as measured with
+// bench-invidx on a current x86 core, plus a fixed cost per list
+template <class t_list>
+struct decode_cost;
+
+template <bool t_dgap>
+struct decode_cost<list_qmx<t_dgap>> {
+	static double ns(size_t n) { return 30 + 0.6 * n; }
+};
+
+template <bool t_dgap>
+struct decode_cost<list_op4<128, t_dgap>> {
+	static double ns(size_t n) { return 20 + 1.1 * n; }
+};
+
+template <bool t_dgap>
+struct decode_cost<list_vbyte<t_dgap>> {
+	static double ns(size_t n) { return 10 + 1.4 * n; }
+};
+
+template <bool t_dgap>
+struct decode_cost<list_simple16<t_dgap>> {
+	static double ns(size_t n) { return 10 + 1.8 * n; }
+};
+
+template <bool t_prefix>
+struct decode_cost<list_ef<t_prefix>> {
+	static double ns(size_t n) { return 10 + 2.3 * n; }
+};
+
+template <bool t_prefix>
+struct decode_cost<list_interp<t_prefix>> {
+	static double ns(size_t n) { return 10 + 15.0 * n; }
+};
+
+// candidates in tag order. doc ids are d-gapped by the block codecs and
+// encoded directly by ef and interp, freqs the other way round.
+template <bool t_dgap>
+struct candidate_list {
+	using type = std::tuple<list_vbyte<t_dgap>, list_op4<128, t_dgap>, list_qmx<t_dgap>,
+	list_ef<!t_dgap>, list_interp<!t_dgap>, list_simple16<t_dgap>>;
+};
+
+// calls into the candidate with tag c
+template <class t_lists, size_t t_i = 0, bool t_last = t_i + 1 == std::tuple_size<t_lists>::value>
+struct by_tag {
+	using list_type = typename std::tuple_element<t_i, t_lists>::type;
+	using next		= by_tag<t_lists, t_i + 1>;
+
+	static void encode(size_t c, bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf,
+	size_t n, size_t universe)
+	{
+		if (c == t_i) return list_type::encode(out, buf, n, universe);
+		next::encode(c, out, buf, n, universe);
+	}
+
+	template <class t_bit_istream>
+	static void
+	decode(size_t c, t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		if (c == t_i) return list_type::decode(in, buf, n, universe);
+		next::decode(c, in, buf, n, universe);
+	}
+
+	static double decode_ns(size_t c, size_t n)
+	{
+		if (c == t_i) return decode_cost<list_type>::ns(n);
+		return next::decode_ns(c, n);
+	}
+};
+
+// tags past the last candidate end up here
+template <class t_lists, size_t t_i>
+struct by_tag<t_lists, t_i, true> {
+	using list_type = typename std::tuple_element<t_i, t_lists>::type;
+
+	static void encode(size_t, bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf,
+	size_t n, size_t universe)
+	{
+		list_type::encode(out, buf, n, universe);
+	}
+
+	template <class t_bit_istream>
+	static void decode(size_t, t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		list_type::decode(in, buf, n, universe);
+	}
+
+	static double decode_ns(size_t, size_t n) { return decode_cost<list_type>::ns(n); }
+};
+}
+
+// t_lambda is the number of bits one ns of decoding is worth
+template <bool t_dgap, uint32_t t_lambda = 0>
+struct list_adaptive {
+	using candidate_types			   = typename adaptive::candidate_list<t_dgap>::type;
+	using by_tag					   = adaptive::by_tag<candidate_types>;
+	static const size_t  num_candidates = std::tuple_size<candidate_types>::value;
+	static const uint8_t tag_bits	   = 8;
+
+	static std::string name() { return "adaptive-l" + std::to_string(t_lambda); }
+
+	static std::string type()
+	{
+		return "adaptive(dgap=" + std::to_string(t_dgap) + ",lambda=" + std::to_string(t_lambda) + ")";
+	}
+
+	static void
+	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		// candidates are encoded into a private stream at the same offset
+		// modulo 128 bits as the real output so alignment padding counts
+		static thread_local sdsl::bit_vector			  trial_bv;
+		static thread_local bit_ostream<sdsl::bit_vector> trial(trial_bv);
+		static thread_local std::vector<uint32_t>		  trial_buf;
+
+		uint64_t start	 = (out.tellp() + tag_bits) % 128;
+		double   lambda	= t_lambda;
+		size_t   best	  = 0;
+		double   best_cost = std::numeric_limits<double>::max();
+		for (size_t c = 0; c < num_candidates; c++) {
+			// only the list itself plus the slack the codecs expect, buf is
+			// a scratch buffer as long as the longest list seen so far
+			trial_buf.assign(buf.begin(), buf.begin() + n);
+			trial_buf.resize(n + 1024);
+			trial.seek(start);
+			by_tag::encode(c, trial, trial_buf, n, universe);
+			double cost = (trial.tellp() - start) + lambda * by_tag::decode_ns(c, n);
+			if (cost < best_cost) {
+				best_cost = cost;
+				best	  = c;
+			}
+		}
+		out.put_int(best, tag_bits);
+		by_tag::encode(best, out, buf, n, universe);
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		by_tag::decode(in.get_int(tag_bits), in, buf, n, universe);
+	}
+};
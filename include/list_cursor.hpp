@@ -0,0 +1,205 @@
+#pragma once
+
+#include "bit_streams.hpp"
+#include "list_dictionary.hpp"
+#include "meta_data.hpp"
+
+#include <algorithm>
+#include <limits>
+
+// postings per skip block of a doc list codec. 0 if the codec has no skip
+// table and a list is always read as a single block.
+template <class t_list>
+struct list_skip_block_size {
+	static constexpr size_t value = 0;
+};
+
+// reads the doc ids of one list block by block. lists without a skip table
+// are treated as a single block holding the whole list. codecs that write a
+// skip table specialize this (see list_skip.hpp, list_pef.hpp); blocks do not
+// have to be of the same size. freq lists are read through the same
+// interface, their blocks hold block_size() postings except the last.
+template <class t_list>
+struct list_block_reader {
+	using dict_type = typename list_dictionary<t_list>::state_type;
+
+	list_block_reader(const bit_view& bv, size_t offset, size_t n, size_t universe,
+	const dict_type* dict = nullptr)
+		: m_bv(&bv), m_offset(offset), m_n(n), m_universe(universe), m_dict(dict)
+	{
+	}
+
+	size_t num_blocks() const { return 1; }
+
+	// max number of postings in a block
+	size_t block_size() const { return m_n; }
+
+	// index of the first posting of block b
+	size_t block_begin(size_t) const { return 0; }
+
+	// upper bound of the doc ids in block b
+	uint32_t block_last(size_t) const { return m_universe; }
+
+	// decode block b into out and return the number of postings in it
+	size_t decode_block(size_t, std::vector<uint32_t>& out) const
+	{
+		bit_istream<bit_view> is(*m_bv);
+		is.seek(m_offset);
+		if (m_dict)
+			list_dictionary<t_list>::decode(*m_dict, is, out, m_n, m_universe);
+		else
+			t_list::decode(is, out, m_n, m_universe);
+		return m_n;
+	}
+
+	const bit_view*  m_bv;
+	size_t			 m_offset;
+	size_t			 m_n;
+	size_t			 m_universe;
+	const dict_type* m_dict;
+};
+
+// forward cursor over a posting list. next_geq() only decodes the block the
+// target falls into when the doc list has a skip table. freqs are decoded on
+// access, one block at a time if the freq list is split into blocks (see
+// list_skip_freqs), otherwise all at once. the cursor references the bits and
+// the list dictionaries of the index it came from.
+template <class t_doc_list, class t_freq_list>
+struct list_cursor {
+	static constexpr uint32_t end_docid = std::numeric_limits<uint32_t>::max();
+	using doc_dict_type					= typename list_dictionary<t_doc_list>::state_type;
+	using freq_dict_type				= typename list_dictionary<t_freq_list>::state_type;
+
+	list_cursor(const bit_view& docs, const bit_view& freqs, const list_meta_data& lm,
+	size_t num_docs, const doc_dict_type* doc_dict = nullptr,
+	const freq_dict_type* freq_dict = nullptr)
+		: m_reader(docs, lm.doc_offset, lm.list_len, num_docs, doc_dict)
+		, m_freq_reader(freqs, lm.freq_offset, lm.list_len, lm.Ft, freq_dict)
+		, m_size(lm.list_len)
+	{
+		m_ids.resize(m_reader.block_size() + 1024); // overhead needed for FastPFor methods
+		if (m_size == 0) {
+			m_cur = end_docid;
+			return;
+		}
+		load_block(0);
+	}
+
+	uint32_t docid() const { return m_cur; }
+
+	size_t size() const { return m_size; }
+
+	// index of the current posting in the list
+	size_t position() const { return m_reader.block_begin(m_block) + m_pos; }
+
+	void next()
+	{
+		if (++m_pos < m_block_len) {
+			m_cur = m_ids[m_pos];
+		} else if (m_block + 1 < m_reader.num_blocks()) {
+			load_block(m_block + 1);
+		} else {
+			m_cur = end_docid;
+		}
+	}
+
+	// move to the first doc id >= id. stays put if already there.
+	void next_geq(uint32_t id)
+	{
+		if (id <= m_cur) return;
+		if (id > m_reader.block_last(m_block)) {
+			size_t b = find_block(m_block + 1, id);
+			if (b == m_reader.num_blocks()) {
+				m_cur = end_docid;
+				m_pos = m_block_len;
+				return;
+			}
+			load_block(b);
+		}
+		auto begin = m_ids.begin() + m_pos;
+		auto end   = m_ids.begin() + m_block_len;
+		m_pos	  = std::lower_bound(begin, end, id) - m_ids.begin();
+		m_cur	  = (m_pos < m_block_len) ? m_ids[m_pos] : end_docid;
+	}
+
+	uint32_t freq()
+	{
+		size_t pos = position();
+		size_t b   = pos / m_freq_reader.block_size();
+		if (b != m_freq_block) {
+			if (m_freqs.empty()) m_freqs.resize(m_freq_reader.block_size() + 1024);
+			m_freq_reader.decode_block(b, m_freqs);
+			m_freq_block = b;
+		}
+		return m_freqs[pos - m_freq_reader.block_begin(b)];
+	}
+
+	// move only the block pointer to the block that can contain id. nothing
+	// is decoded; used to look up per block score bounds.
+	void next_shallow(uint32_t id)
+	{
+		size_t from = std::max(m_block, m_shallow);
+		if (from < m_reader.num_blocks() && id <= m_reader.block_last(from)) {
+			m_shallow = from;
+		} else {
+			m_shallow = find_block(from + 1, id);
+		}
+	}
+
+	// block selected by next_shallow() or num_blocks() if beyond the list
+	size_t shallow_block() const { return m_shallow; }
+
+	// last doc id of the shallow block
+	uint32_t shallow_last() const
+	{
+		return m_shallow < m_reader.num_blocks() ? m_reader.block_last(m_shallow) : end_docid;
+	}
+
+private:
+	// first block >= from whose last doc id is >= id. gallops over the skip
+	// table, then binary searches the last step.
+	size_t find_block(size_t from, uint32_t id) const
+	{
+		size_t num_blocks = m_reader.num_blocks();
+		size_t lo		  = from;
+		size_t step		  = 1;
+		size_t hi		  = lo;
+		while (hi < num_blocks && m_reader.block_last(hi) < id) {
+			lo = hi + 1;
+			hi += step;
+			step *= 2;
+		}
+		hi = std::min(hi, num_blocks);
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+			if (m_reader.block_last(mid) < id)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	void load_block(size_t b)
+	{
+		m_block		= b;
+		m_block_len = m_reader.decode_block(b, m_ids);
+		m_pos		= 0;
+		m_cur		= m_ids[0];
+	}
+
+	list_block_reader<t_doc_list>  m_reader;
+	list_block_reader<t_freq_list> m_freq_reader;
+	size_t						   m_size;
+	std::vector<uint32_t>		   m_ids;
+	std::vector<uint32_t>		   m_freqs;
+	size_t						   m_block		= 0;
+	size_t						   m_block_len	= 0;
+	size_t						   m_pos		= 0;
+	size_t						   m_shallow	= 0;
+	size_t						   m_freq_block	= std::numeric_limits<size_t>::max();
+	uint32_t					   m_cur		= end_docid;
+};
+
+template <class t_doc_list, class t_freq_list>
+constexpr uint32_t list_cursor<t_doc_list, t_freq_list>::end_docid;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "logging.hpp"
+
+#include <deque>
+#include <vector>
+
+struct list_data {
+	size_t				  list_len = 0;
+	std::vector<uint32_t> doc_ids;
+	std::vector<uint32_t> freqs;
+
+	list_data() {}
+
+	list_data(size_t n) { grow(n); }
+
+	// make room for a list of n postings. buffers never shrink so a reused
+	// list_data stops allocating once it has seen the longest list.
+	void grow(size_t n)
+	{
+		if (doc_ids.size() < n + 1024) { // overhead needed for FastPFor methods
+			doc_ids.resize(n + 1024);
+			freqs.resize(n + 1024);
+		}
+	}
+
+	bool operator!=(const list_data& other) const
+	{
+		if (list_len != other.list_len) {
+			LOG(ERROR) << "list len not equal";
+			return true;
+		}
+
+		for (size_t i = 0; i < list_len; i++) {
+			if (doc_ids[i] != other.doc_ids[i]) {
+				LOG(ERROR) << "doc id data not equal";
+				return true;
+			}
+			if (freqs[i] != other.freqs[i]) {
+				LOG(ERROR) << "freq data not equal";
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+// per-thread pool of decode buffers. each query thread owns its own slots so a
+// single loaded index can be shared by many threads without locking. a deque is
+// used so growing the pool does not invalidate slots handed out earlier.
+struct list_scratch {
+	static list_data& get(size_t slot = 0)
+	{
+		static thread_local std::deque<list_data> pool;
+		if (pool.size() <= slot) pool.resize(slot + 1);
+		return pool[slot];
+	}
+
+	static std::vector<uint32_t>& buf(size_t n)
+	{
+		static thread_local std::vector<uint32_t> tmp;
+		if (tmp.size() < n + 1024) tmp.resize(n + 1024);
+		return tmp;
+	}
+};
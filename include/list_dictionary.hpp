@@ -0,0 +1,75 @@
+#pragma once
+
+#include "bit_streams.hpp"
+
+#include <vector>
+
+// list types with a dictionary_state share one dictionary across all lists of
+// an index. the index owns the dictionary: it trains it before encoding the
+// first list, stores it in front of the list data and hands it to every
+// encode and decode of the list type, so indexes of the same list type can be
+// open at the same time. lists without a dictionary use the defaults below.
+struct no_list_dictionary {
+};
+
+template <class>
+struct list_dictionary_void {
+	using type = void;
+};
+
+template <class t_list, class = void>
+struct list_dictionary {
+	using state_type = no_list_dictionary;
+
+	template <class t_lists>
+	static void train(state_type&, const t_lists&)
+	{
+	}
+	static void write(bit_ostream<sdsl::bit_vector>&, const state_type&) {}
+	template <class t_bit_istream>
+	static void read(t_bit_istream&, state_type&)
+	{
+	}
+	static void encode(const state_type&, bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf,
+	size_t n, size_t universe)
+	{
+		t_list::encode(out, buf, n, universe);
+	}
+	template <class t_bit_istream>
+	static void decode(const state_type&, t_bit_istream& in, std::vector<uint32_t>& buf, size_t n,
+	size_t universe)
+	{
+		t_list::decode(in, buf, n, universe);
+	}
+};
+
+template <class t_list>
+struct list_dictionary<t_list, typename list_dictionary_void<typename t_list::dictionary_state>::type> {
+	using state_type = typename t_list::dictionary_state;
+
+	template <class t_lists>
+	static void train(state_type& state, const t_lists& lists)
+	{
+		t_list::train_dictionary(state, lists);
+	}
+	static void write(bit_ostream<sdsl::bit_vector>& out, const state_type& state)
+	{
+		t_list::write_dictionary(out, state);
+	}
+	template <class t_bit_istream>
+	static void read(t_bit_istream& in, state_type& state)
+	{
+		t_list::read_dictionary(in, state);
+	}
+	static void encode(const state_type& state, bit_ostream<sdsl::bit_vector>& out,
+	std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		t_list::encode(out, buf, n, universe, state);
+	}
+	template <class t_bit_istream>
+	static void decode(const state_type& state, t_bit_istream& in, std::vector<uint32_t>& buf, size_t n,
+	size_t universe)
+	{
+		t_list::decode(in, buf, n, universe, state);
+	}
+};
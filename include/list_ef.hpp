@@ -20,7 +20,8 @@ struct list_ef {
         ef_coder.encode(out,in,n,universe);
     }
     
-    static void decode(bit_istream<sdsl::bit_vector>& in,std::vector<uint32_t>& buf,size_t n,size_t universe) {
+    template<class t_bit_istream>
+    static void decode(t_bit_istream& in,std::vector<uint32_t>& buf,size_t n,size_t universe) {
         static coder::elias_fano ef_coder;
         auto out = buf.data();
         ef_coder.decode(in,out,n,universe);
@@ -21,12 +21,25 @@ struct list_interp {
         
     }
     
-    static void decode(bit_istream<sdsl::bit_vector>& in,std::vector<uint32_t>& buf,size_t n,size_t universe) {
+    template<class t_bit_istream>
+    static void decode(t_bit_istream& in,std::vector<uint32_t>& buf,size_t n,size_t universe) {
         static coder::interpolative interp_coder;
         auto out = buf.data();
         interp_coder.decode(in,out,n,universe);
         if(t_prefix) utils::undo_prefixsum_list(buf,n);
         
     }
+
+    // only the doc ids in [lo,hi] are moved to the front of buf and their
+    // number is returned. decoding stops once the list is past hi.
+    template<class t_bit_istream>
+    static size_t decode_range(t_bit_istream& in,std::vector<uint32_t>& buf,size_t n,size_t universe,uint32_t lo,uint32_t hi) {
+        static_assert(!t_prefix,"range decoding needs the values themselves");
+        static coder::interpolative interp_coder;
+        size_t first,last;
+        interp_coder.decode_range(in,buf.data(),n,universe,lo,hi,first,last);
+        std::copy(buf.begin()+first,buf.begin()+last,buf.begin());
+        return last-first;
+    }
 };
 
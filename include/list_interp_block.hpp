@@ -63,7 +63,8 @@ struct list_interp_block {
         }
     }
     
-    static void decode(bit_istream<sdsl::bit_vector>& in,std::vector<uint32_t>& buf,size_t n,size_t universe) {
+    template<class t_bit_istream>
+    static void decode(t_bit_istream& in,std::vector<uint32_t>& buf,size_t n,size_t universe) {
         // small lists
         if(n < t_block_size) {
             list_interp<t_prefix>::decode(in,buf,n,universe);
@@ -72,7 +73,8 @@ struct list_interp_block {
         
         // decode the skips first
         size_t num_skips = n / t_block_size;
-        std::vector<uint32_t> skips(num_skips);
+        static thread_local std::vector<uint32_t> skips;
+        skips.resize(num_skips);
         static coder::fixed<32> skip_coder;
         skip_coder.decode(in,skips.data(),num_skips);
         
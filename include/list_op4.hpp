@@ -14,8 +14,8 @@ struct list_op4 {
 	static void
 	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t)
 	{
-		static FastPForLib::OPTPFor<t_block_size / 32> optpfor_coder;
-		static coder::vbyte_fastpfor				   vcoder;
+		static thread_local FastPForLib::OPTPFor<t_block_size / 32> optpfor_coder;
+		static coder::vbyte_fastpfor								vcoder;
 		if (t_dgap) utils::dgap_list(buf, n);
 		size_t bits_needed = 256ULL * 1024ULL + 40ULL * buf.size();
 		out.expand_if_needed(bits_needed);
@@ -44,14 +44,17 @@ struct list_op4 {
 		}
 	}
 
-	static void
-	decode(bit_istream<sdsl::bit_vector>& in, std::vector<uint32_t>& buf, size_t n, size_t)
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t)
 	{
-		static FastPForLib::OPTPFor<t_block_size / 32> optpfor_coder;
-		static coder::vbyte_fastpfor				   vcoder;
+		// optpfor keeps its exception buffers as members so each thread needs its own
+		static thread_local FastPForLib::OPTPFor<t_block_size / 32> optpfor_coder;
+		static coder::vbyte_fastpfor								vcoder;
 		in.align8();
 		const uint32_t* in32  = (const uint32_t*)in.cur_data8();
 		uint32_t*		out32 = buf.data();
+		// d-gaps are undone block by block while the block is still in cache
+		uint32_t base = 0;
 		for (size_t i = 0; i < n; i += t_block_size) {
 			size_t elems					= t_block_size;
 			if (n - i < t_block_size) elems = n - i;
@@ -62,10 +65,10 @@ struct list_op4 {
 				auto   newin32		  = optpfor_coder.decodeBlock(in32, out32, read_ints);
 				size_t processed_ints = newin32 - in32;
 				in32				  = newin32;
-				out32 += t_block_size;
 				in.skip(processed_ints * sizeof(uint32_t) * 8);
 			}
+			if (t_dgap) base = utils::prefix_sum(out32, elems, base);
+			out32 += elems;
 		}
-		if (t_dgap) utils::undo_dgap_list(buf, n);
 	}
 };
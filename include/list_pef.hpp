@@ -0,0 +1,315 @@
+#pragma once
+
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+#include "list_cursor.hpp"
+
+// partitioned Elias-Fano (Ottaviano and Venturini 2014). a strictly
+// increasing list is split into partitions chosen by the approximate optimal
+// partitioning DP and every partition is stored relative to the last value of
+// the one before it as
+//
+//   run:	 partition covers its universe completely, nothing is stored
+//   bitmap:  one bit per value of the universe
+//   ef:	  Elias-Fano with the partition's own universe and low width
+//
+// whichever is smallest. the representation and the size of a partition
+// follow from its length and universe (ef partitions are padded to their
+// bound), so neither is stored. lists of more than one partition are
+//
+//   [P:gamma][ends:ef][lasts:ef][partitions]
+//
+// with ends the cumulative partition sizes and lasts the last value of every
+// partition. a list of a single partition only has [1:gamma][partition].
+namespace pef {
+
+// bits charged per partition for its entries in the top level sequences
+const uint64_t partition_overhead = 64;
+// approximation parameters of the DP as in the paper
+const double eps1 = 0.03;
+const double eps2 = 0.3;
+
+enum class encoding { run, bitmap, ef };
+
+inline uint8_t ef_width_low(uint64_t n, uint64_t u)
+{
+	uint8_t logm = sdsl::bits::hi(n) + 1;
+	uint8_t logu = sdsl::bits::hi(u) + 1;
+	if (logu < logm) return 1;
+	if (logm == logu) logm--;
+	return logu - logm;
+}
+
+// upper bound of coder::elias_fano for n values below u
+inline uint64_t ef_bits(uint64_t n, uint64_t u)
+{
+	uint8_t width_low = ef_width_low(n, u);
+	return n * width_low + n + (u >> width_low) + 1;
+}
+
+inline encoding partition_encoding(uint64_t n, uint64_t u)
+{
+	if (n == u) return encoding::run;
+	if (u <= ef_bits(n, u)) return encoding::bitmap;
+	return encoding::ef;
+}
+
+inline uint64_t partition_bits(uint64_t n, uint64_t u)
+{
+	switch (partition_encoding(n, u)) {
+		case encoding::run:
+			return 0;
+		case encoding::bitmap:
+			return u;
+		default:
+			return ef_bits(n, u);
+	}
+}
+
+// a candidate partition [start,end). its universe starts behind the last
+// value before it.
+struct cost_window {
+	cost_window(const uint32_t* data, uint64_t bound) : m_data(data), m_cost_bound(bound) {}
+
+	uint64_t universe() const { return m_max - m_min + 1; }
+	uint64_t size() const { return m_end - m_start; }
+
+	void advance_start() { m_min = uint64_t(m_data[m_start++]) + 1; }
+	void advance_end() { m_max = m_data[m_end++]; }
+
+	const uint32_t* m_data;
+	uint64_t		m_cost_bound;
+	size_t			m_start = 0;
+	size_t			m_end   = 0;
+	uint64_t		m_min   = 0;
+	uint64_t		m_max   = 0;
+};
+
+// ends of the partitions of data[0,n) minimizing the encoded size within a
+// factor of (1+eps1)(1+eps2). keeps one window per cost class so the DP runs
+// in O(n log(1/eps1)/log(1+eps2)).
+inline std::vector<size_t> optimal_partition(const uint32_t* data, size_t n)
+{
+	auto cost = [](uint64_t u, uint64_t m) { return partition_overhead + partition_bits(m, u); };
+	uint64_t single_cost = cost(uint64_t(data[n - 1]) + 1, n);
+
+	std::vector<cost_window> windows;
+	uint64_t				 cost_lb	= cost(1, 1);
+	double					 cost_bound = cost_lb;
+	while (cost_bound < cost_lb / eps1) {
+		windows.emplace_back(data, uint64_t(cost_bound));
+		if (cost_bound >= single_cost) break;
+		cost_bound *= 1 + eps2;
+	}
+
+	std::vector<uint64_t> min_cost(n + 1, single_cost);
+	std::vector<size_t>   path(n + 1, 0);
+	min_cost[0] = 0;
+	for (size_t i = 0; i < n; i++) {
+		size_t last_end = i + 1;
+		for (auto& window : windows) {
+			while (window.m_end < last_end)
+				window.advance_end();
+			while (true) {
+				uint64_t window_cost = cost(window.universe(), window.size());
+				if (min_cost[i] + window_cost < min_cost[window.m_end]) {
+					min_cost[window.m_end] = min_cost[i] + window_cost;
+					path[window.m_end]	 = i;
+				}
+				last_end = window.m_end;
+				if (window.m_end == n || window_cost >= window.m_cost_bound) break;
+				window.advance_end();
+			}
+			window.advance_start();
+		}
+	}
+
+	std::vector<size_t> ends;
+	for (size_t pos = n; pos != 0; pos = path[pos])
+		ends.push_back(pos);
+	std::reverse(ends.begin(), ends.end());
+	return ends;
+}
+
+inline void encode_partition(bit_ostream<sdsl::bit_vector>& out, uint32_t* data, size_t n, uint64_t base, uint64_t u)
+{
+	for (size_t i = 0; i < n; i++)
+		data[i] -= base;
+	switch (partition_encoding(n, u)) {
+		case encoding::run:
+			break;
+		case encoding::bitmap: {
+			std::vector<uint64_t> words((u + 63) / 64);
+			for (size_t i = 0; i < n; i++)
+				words[data[i] / 64] |= uint64_t(1) << (data[i] % 64);
+			for (uint64_t i = 0; i < u; i += 64)
+				out.put_int(words[i / 64], std::min(uint64_t(64), u - i));
+			break;
+		}
+		default: {
+			coder::elias_fano ef_coder;
+			auto			  end = out.tellp() + ef_bits(n, u);
+			ef_coder.encode(out, data, n, u);
+			while (out.tellp() < end)
+				out.put_int(0, std::min(uint64_t(64), end - out.tellp()));
+		}
+	}
+	for (size_t i = 0; i < n; i++)
+		data[i] += base;
+}
+
+template <class t_bit_istream>
+void decode_partition(const t_bit_istream& in, uint32_t* out, size_t n, uint64_t base, uint64_t u)
+{
+	switch (partition_encoding(n, u)) {
+		case encoding::run:
+			for (size_t i = 0; i < n; i++)
+				out[i] = base + i;
+			break;
+		case encoding::bitmap: {
+			size_t i = 0;
+			for (uint64_t pos = 0; pos < u; pos += 64) {
+				uint64_t word = in.get_int(std::min(uint64_t(64), u - pos));
+				while (word) {
+					out[i++] = base + pos + __builtin_ctzll(word);
+					word &= word - 1;
+				}
+			}
+			break;
+		}
+		default: {
+			coder::elias_fano ef_coder;
+			ef_coder.decode(in, out, n, u);
+			for (size_t i = 0; i < n; i++)
+				out[i] += base;
+		}
+	}
+}
+
+// the top level of a list: where partitions end, their last values and
+// where their data starts
+struct partition_table {
+	partition_table() {}
+
+	template <class t_bit_istream>
+	partition_table(const t_bit_istream& in, size_t n, uint64_t u)
+	{
+		size_t num_partitions = in.get_gamma();
+		m_ends.resize(num_partitions);
+		m_lasts.resize(num_partitions);
+		m_offsets.resize(num_partitions + 1);
+		if (num_partitions == 1) {
+			m_lasts[0] = u - 1;
+		} else {
+			coder::elias_fano ef_coder;
+			ef_coder.decode(in, m_ends.data(), num_partitions - 1, n);
+			ef_coder.decode(in, m_lasts.data(), num_partitions, u);
+		}
+		m_ends[num_partitions - 1] = n;
+		m_offsets[0]			   = in.tellg();
+		for (size_t p = 0; p < num_partitions; p++) {
+			m_offsets[p + 1] = m_offsets[p] + partition_bits(len(p), universe(p));
+			m_max_size		 = std::max(m_max_size, len(p));
+		}
+	}
+
+	size_t   size() const { return m_ends.size(); }
+	size_t   begin(size_t p) const { return p ? m_ends[p - 1] : 0; }
+	size_t   len(size_t p) const { return m_ends[p] - begin(p); }
+	uint64_t base(size_t p) const { return p ? uint64_t(m_lasts[p - 1]) + 1 : 0; }
+	uint64_t universe(size_t p) const { return m_lasts[p] - base(p) + 1; }
+
+	template <class t_bit_istream>
+	void decode(const t_bit_istream& in, size_t p, uint32_t* out) const
+	{
+		in.seek(m_offsets[p]);
+		decode_partition(in, out, len(p), base(p), universe(p));
+	}
+
+	// end of the list
+	uint64_t end() const { return m_offsets.back(); }
+
+	std::vector<uint32_t> m_ends;
+	std::vector<uint32_t> m_lasts;
+	std::vector<uint64_t> m_offsets;
+	size_t				  m_max_size = 0;
+};
+}
+
+// values are at most universe, so the same universe works for doc ids and for
+// prefix summed freqs as with list_ef
+template <bool t_prefix>
+struct list_pef {
+	static std::string name() { return "pef"; }
+
+	static std::string type() { return "pef(prefix=" + std::to_string(t_prefix) + ")"; }
+
+	static void
+	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		if (t_prefix) utils::prefixsum_list(buf, n);
+		uint64_t u	= uint64_t(universe) + 1;
+		auto	 ends = pef::optimal_partition(buf.data(), n);
+		out.put_gamma(ends.size());
+		if (ends.size() == 1) {
+			pef::encode_partition(out, buf.data(), n, 0, u);
+			return;
+		}
+
+		std::vector<uint32_t> lasts(ends.size());
+		for (size_t p = 0; p < ends.size(); p++)
+			lasts[p] = buf[ends[p] - 1];
+		coder::elias_fano ef_coder;
+		ef_coder.encode(out, ends.data(), ends.size() - 1, n);
+		ef_coder.encode(out, lasts.data(), ends.size(), u);
+		size_t   begin = 0;
+		uint64_t base  = 0;
+		for (size_t p = 0; p < ends.size(); p++) {
+			pef::encode_partition(out, buf.data() + begin, ends[p] - begin, base, lasts[p] - base + 1);
+			begin = ends[p];
+			base  = uint64_t(lasts[p]) + 1;
+		}
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		uint64_t			 u = uint64_t(universe) + 1;
+		pef::partition_table table(in, n, u);
+		for (size_t p = 0; p < table.size(); p++)
+			table.decode(in, p, buf.data() + table.begin(p));
+		in.seek(table.end());
+		if (t_prefix) utils::undo_prefixsum_list(buf, n);
+	}
+};
+
+// partitions are the blocks of a cursor, next_geq() skips whole partitions
+// through their last values
+template <>
+struct list_block_reader<list_pef<false>> {
+	list_block_reader(const bit_view& bv, size_t offset, size_t n, size_t universe,
+	const no_list_dictionary* = nullptr) : m_bv(&bv)
+	{
+		bit_istream<bit_view> is(bv);
+		is.seek(offset);
+		m_table = pef::partition_table(is, n, uint64_t(universe) + 1);
+	}
+
+	size_t num_blocks() const { return m_table.size(); }
+
+	size_t block_size() const { return m_table.m_max_size; }
+
+	size_t block_begin(size_t b) const { return m_table.begin(b); }
+
+	uint32_t block_last(size_t b) const { return m_table.m_lasts[b]; }
+
+	size_t decode_block(size_t b, std::vector<uint32_t>& out) const
+	{
+		bit_istream<bit_view> is(*m_bv);
+		m_table.decode(is, b, out.data());
+		return m_table.len(b);
+	}
+
+	const bit_view*		 m_bv;
+	pef::partition_table m_table;
+};
@@ -5,6 +5,8 @@
 
 #include "compress_qmx.h"
 
+#include <cstring>
+
 template <bool t_dgap>
 struct list_qmx {
 	static std::string name() { return "qmx"; }
@@ -14,7 +16,7 @@ struct list_qmx {
 	static void
 	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t)
 	{
-		static compress_qmx qmxcoder;
+		static thread_local compress_qmx qmxcoder;
 		if (t_dgap) utils::dgap_list(buf, n);
 		size_t bits_expected = 256ULL * 1024ULL + 40ULL * buf.size();
 		out.expand_if_needed(bits_expected);
@@ -36,8 +38,8 @@ struct list_qmx {
 		out.skip(bits_written);
 	}
 
-	static void
-	decode(bit_istream<sdsl::bit_vector>& in, std::vector<uint32_t>& buf, size_t n, size_t)
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t)
 	{
 		static compress_qmx qmxcoder;
 
@@ -50,7 +52,16 @@ struct list_qmx {
 		// align 128 and read
 		in.align128();
 
-		in32				= (const uint32_t*)in.cur_data8();
+		in32 = (const uint32_t*)in.cur_data8();
+		// qmx uses aligned loads. a mmapped stream starts after the 8 byte
+		// sdsl header so copy the payload to an aligned buffer in that case
+		if (((uintptr_t)in32 & 0x0F) != 0) {
+			static thread_local std::vector<uint8_t> tmp;
+			tmp.resize(input_buffer_size + 32);
+			auto aligned = (uint8_t*)(((uintptr_t)tmp.data() + 15) & ~(uintptr_t)0x0F);
+			memcpy(aligned, in32, input_buffer_size);
+			in32 = (const uint32_t*)aligned;
+		}
 		uint32_t* out		= buf.data();
 		size_t	read_ints = n;
 		qmxcoder.decodeArray(in32, input_buffer_size, out, read_ints);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+
+// d-gaps or freqs entropy coded with rANS. the symbol statistics of every
+// list are stored with the list, so short lists stay vbyte only as in
+// list_vbyte_lz where the table would cost more than it saves.
+template <bool t_dgap, size_t t_thres>
+struct list_rans {
+	static std::string name() { return "rans"; }
+
+	static std::string type()
+	{
+		return "rans(dgap=" + std::to_string(t_dgap) + "-" + std::to_string(t_thres) + ")";
+	}
+
+	static void
+	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t)
+	{
+		static coder::vbyte_fastpfor vcoder;
+		static coder::rans			 rcoder;
+		if (t_dgap) utils::dgap_list(buf, n);
+		if (n <= t_thres) {
+			vcoder.encode(out, buf.data(), n);
+			return;
+		}
+		rcoder.encode(out, buf.data(), n);
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t)
+	{
+		static coder::vbyte_fastpfor vcoder;
+		static coder::rans			 rcoder;
+		if (n <= t_thres) {
+			vcoder.decode(in, buf.data(), n);
+		} else {
+			rcoder.decode(in, buf.data(), n);
+		}
+		if (t_dgap) utils::undo_dgap_list(buf, n);
+	}
+};
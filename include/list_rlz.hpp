@@ -0,0 +1,230 @@
+#pragma once
+
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+#include "dict_index_sa_u32.hpp"
+#include "list_dictionary.hpp"
+#include "utils.hpp"
+
+#include <cstring>
+#include <memory>
+
+// relative lempel-ziv over the integers of the lists. d-gaps (or freqs) are
+// factorized greedily against a dictionary of integers sampled from all lists
+// of the index, so repeated gap patterns become (offset,length) factors and
+// decoding copies whole runs of integers out of the dictionary. integers not
+// covered by a factor of at least min_factor_len are kept as literal runs.
+//
+// list layout: [tokens+1:gamma][tokens:vbyte][offsets:offset_bits each][literals:vbyte]
+// with token = len << 1 | is_factor. the dictionary is owned by the index,
+// passed to encode and decode (see list_dictionary) and stored in front of
+// the lists: [ints:32][dictionary ints]
+template <bool t_dgap, size_t t_thres = 128>
+struct list_rlz {
+	static const size_t dict_ints	  = 64 * 1024;
+	static const size_t sample_ints	= 256;
+	static const size_t min_factor_len = 3;
+
+	static std::string name() { return "rlz"; }
+
+	static std::string type()
+	{
+		return "rlz(dgap=" + std::to_string(t_dgap) + "-" + std::to_string(t_thres) + "-" +
+			   std::to_string(dict_ints) + ")";
+	}
+
+	// the dictionary and, when encoding, its suffix array. the suffix array
+	// references dict, so the state is neither copied nor moved.
+	struct dictionary_state {
+		std::vector<uint32_t>			   dict;
+		std::unique_ptr<dict_index_sa_u32> index;
+		uint8_t							   offset_bits = 1;
+
+		dictionary_state() = default;
+		dictionary_state(const dictionary_state&) = delete;
+		dictionary_state& operator=(const dictionary_state&) = delete;
+
+		void reset(std::vector<uint32_t> d, bool build_index = false)
+		{
+			index.reset();
+			dict		= std::move(d);
+			offset_bits = dict.size() > 1 ? sdsl::bits::hi(dict.size() - 1) + 1 : 1;
+			if (build_index && !dict.empty()) index.reset(new dict_index_sa_u32(dict));
+		}
+	};
+
+	static const dictionary_state& no_dictionary()
+	{
+		static const dictionary_state state;
+		return state;
+	}
+
+	// sample_ints long pieces spread evenly over the lists handled by rlz
+	template <class t_lists>
+	static void train_dictionary(dictionary_state& state, const t_lists& lists)
+	{
+		size_t total = 0;
+		for (const auto& l : lists)
+			if (l.size() > t_thres) total += l.size();
+		size_t step = std::max(size_t(sample_ints), total / (dict_ints / sample_ints));
+
+		std::vector<uint32_t> dict;
+		std::vector<uint32_t> buf;
+		size_t				  pos  = 0;
+		size_t				  next = 0;
+		for (const auto& l : lists) {
+			if (l.size() <= t_thres) continue;
+			if (next < pos + l.size()) {
+				buf.assign(l.begin(), l.end());
+				if (t_dgap) utils::dgap_list(buf, buf.size());
+				while (next < pos + l.size() && dict.size() < dict_ints) {
+					size_t first = next - pos;
+					size_t last  = std::min(first + sample_ints, l.size());
+					dict.insert(dict.end(), buf.begin() + first, buf.begin() + last);
+					next += step;
+				}
+			}
+			pos += l.size();
+		}
+		dict.resize(std::min(dict.size(), size_t(dict_ints)));
+		if (dict.empty()) {
+			LOG(INFO) << "no rlz dictionary sampled, lists are stored as literals";
+		}
+		state.reset(std::move(dict), true);
+	}
+
+	static void write_dictionary(bit_ostream<sdsl::bit_vector>& out, const dictionary_state& state)
+	{
+		const auto& dict = state.dict;
+		out.expand_if_needed(128 + dict.size() * 32ULL);
+		out.put_int(dict.size(), 32);
+		out.align64();
+		memcpy(out.cur_data8(), dict.data(), dict.size() * sizeof(uint32_t));
+		out.skip(dict.size() * 32ULL);
+	}
+
+	template <class t_bit_istream>
+	static void read_dictionary(t_bit_istream& in, dictionary_state& state)
+	{
+		size_t size = in.get_int(32);
+		in.align64();
+		const uint32_t* data = (const uint32_t*)in.cur_data8();
+		state.reset(std::vector<uint32_t>(data, data + size));
+		in.skip(size * 32ULL);
+	}
+
+	static void
+	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		encode(out, buf, n, universe, no_dictionary());
+	}
+
+	static void encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t,
+	const dictionary_state& state)
+	{
+		static coder::vbyte_fastpfor vcoder;
+		if (t_dgap) utils::dgap_list(buf, n);
+
+		// (0) small lists remain vbyte only
+		if (n <= t_thres) {
+			vcoder.encode(out, buf.data(), n);
+			return;
+		}
+
+		// (1) greedy factorization against the dictionary
+		static thread_local std::vector<uint32_t> tokens;
+		static thread_local std::vector<uint64_t> offsets;
+		static thread_local std::vector<uint32_t> literals;
+		tokens.clear();
+		offsets.clear();
+		literals.clear();
+		size_t literal_run = 0;
+		for (size_t i = 0; i < n;) {
+			uint64_t offset = 0;
+			size_t   len	= 0;
+			if (state.index) len = state.index->longest_match(buf.data() + i, buf.data() + n, offset);
+			if (len < min_factor_len) {
+				literals.push_back(buf[i]);
+				literal_run++;
+				i++;
+				continue;
+			}
+			if (literal_run) tokens.push_back(literal_run << 1);
+			literal_run = 0;
+			tokens.push_back(len << 1 | 1);
+			offsets.push_back(offset);
+			i += len;
+		}
+		if (literal_run) tokens.push_back(literal_run << 1);
+
+		// (2) write the three streams
+		out.put_gamma(tokens.size() + 1);
+		vcoder.encode(out, tokens.data(), tokens.size());
+		out.expand_if_needed(offsets.size() * state.offset_bits);
+		for (auto offset : offsets)
+			out.put_int(offset, state.offset_bits);
+		vcoder.encode(out, literals.data(), literals.size());
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		decode(in, buf, n, universe, no_dictionary());
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t,
+	const dictionary_state& state)
+	{
+		static coder::vbyte_fastpfor vcoder;
+		// (0) small lists remain vbyte only
+		if (n <= t_thres) {
+			vcoder.decode(in, buf.data(), n);
+			if (t_dgap) utils::undo_dgap_list(buf, n);
+			return;
+		}
+
+		// (1) tokens, offsets and literals
+		static thread_local std::vector<uint32_t> tokens;
+		static thread_local std::vector<uint32_t> offsets;
+		static thread_local std::vector<uint32_t> literals;
+		size_t									  num_tokens = in.get_gamma() - 1;
+		if (tokens.size() < num_tokens + 1024) tokens.resize(num_tokens + 1024);
+		vcoder.decode(in, tokens.data(), num_tokens);
+		size_t num_factors  = 0;
+		size_t num_literals = 0;
+		for (size_t i = 0; i < num_tokens; i++) {
+			if (tokens[i] & 1)
+				num_factors++;
+			else
+				num_literals += tokens[i] >> 1;
+		}
+		if (num_factors && state.dict.empty()) {
+			LOG(FATAL) << "rlz list with factors decoded without its dictionary";
+			throw std::runtime_error("rlz list decoded without its dictionary.");
+		}
+		if (offsets.size() < num_factors) offsets.resize(num_factors);
+		for (size_t i = 0; i < num_factors; i++)
+			offsets[i] = in.get_int(state.offset_bits);
+		if (literals.size() < num_literals + 1024) literals.resize(num_literals + 1024);
+		vcoder.decode(in, literals.data(), num_literals);
+
+		// (2) copy runs of integers from the dictionary and the literals
+		uint32_t*		out			= buf.data();
+		const uint32_t* literal_ptr = literals.data();
+		const uint32_t* offset_ptr  = offsets.data();
+		const uint32_t* dict		= state.dict.data();
+		for (size_t i = 0; i < num_tokens; i++) {
+			size_t len = tokens[i] >> 1;
+			if (tokens[i] & 1) {
+				memcpy(out, dict + *offset_ptr++, len * sizeof(uint32_t));
+			} else {
+				memcpy(out, literal_ptr, len * sizeof(uint32_t));
+				literal_ptr += len;
+			}
+			out += len;
+		}
+
+		if (t_dgap) utils::undo_dgap_list(buf, n);
+	}
+};
@@ -43,26 +43,28 @@ struct list_s16_lz {
 		size_t num_u32 = tmp.size() / 32;
 		out.put_int(num_u32, 32);
 		const uint32_t*	vbyte_data = (const uint32_t*)tmp.data();
-		static t_ent_coder ent_coder;
+		static thread_local t_ent_coder ent_coder;
 		ent_coder.encode(out, vbyte_data, num_u32);
 	}
 
-	static void
-	decode(bit_istream<sdsl::bit_vector>& in, std::vector<uint32_t>& buf, size_t n, size_t)
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t)
 	{
 		static coder::vbyte_fastpfor vcoder;
 		// (0) small lists remain vbyte only
 		if (n <= t_thres) {
-			vcoder.decode(in, buf.data(), n);
-			if (t_dgap) utils::undo_dgap_list(buf, n);
+			if (t_dgap)
+				vcoder.decode_dgap(in, buf.data(), n);
+			else
+				vcoder.decode(in, buf.data(), n);
 			return;
 		}
 
 		// (1) undo the entropy coder
-		size_t					num_u32 = in.get_int(32);
-		static sdsl::bit_vector tmp(30 * 1024 * 1024 * 32);
-		uint32_t*				s16_data = (uint32_t*)tmp.data();
-		static t_ent_coder		ent_coder;
+		size_t						   num_u32  = in.get_int(32);
+		auto&						   tmp	  = utils::thread_scratch(num_u32);
+		uint32_t*					   s16_data = (uint32_t*)tmp.data();
+		static thread_local t_ent_coder ent_coder;
 		ent_coder.decode(in, s16_data, num_u32);
 
 		// (2) undo the simple16
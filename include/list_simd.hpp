@@ -0,0 +1,173 @@
+#pragma once
+
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+
+#include "simdbinarypacking.h"
+#include "simple8b.h" // needed by simdfastpfor.h
+#include "simdfastpfor.h"
+#include "simdvariablebyte.h"
+#include "streamvariablebyte.h"
+#include "VarIntG8IU.h"
+
+#include <cstring>
+
+// the SIMD codecs shipped with FastPFor. the block codecs only take multiples
+// of their block size and use aligned loads and stores, the byte oriented
+// codecs take any length and work on unaligned memory. a dgap_codec_type
+// other than codec_type undoes d-gaps in its decoder while the values are
+// still in registers instead of in a second pass over the list.
+namespace simd_codec {
+
+// Stream VByte over d-gaps. the decoder adds up the gaps as it shuffles the
+// values into place.
+struct streamvbyte_d1_codec {
+	void encodeArray(const uint32_t* in, const size_t count, uint32_t* out, size_t& nvalue)
+	{
+		uint64_t bytes_written = FastPForLib::svb_encode((uint8_t*)out, in, count, 1, 1);
+		nvalue				   = (bytes_written + 3) / 4;
+	}
+
+	const uint32_t* decodeArray(const uint32_t* in, const size_t, uint32_t* out, size_t& nvalue)
+	{
+		uint32_t count   = *in;
+		uint8_t* key_ptr = (uint8_t*)(in + 1);
+		nvalue			 = count;
+		FastPForLib::svb_decode_avx_d1_simple(out, key_ptr, key_ptr + (count + 3) / 4, count);
+		return in;
+	}
+};
+
+struct bp128 {
+	using codec_type				 = FastPForLib::SIMDBinaryPacking;
+	using dgap_codec_type			 = codec_type;
+	static const size_t block_size = 128;
+	static const bool   aligned	= true;
+	static std::string  name() { return "simdbp128"; }
+};
+
+struct fastpfor {
+	using codec_type				 = FastPForLib::SIMDFastPFor<4>;
+	using dgap_codec_type			 = codec_type;
+	static const size_t block_size = 128;
+	static const bool   aligned	= true;
+	static std::string  name() { return "simdfastpfor"; }
+};
+
+struct streamvbyte {
+	using codec_type				 = FastPForLib::StreamVByte;
+	using dgap_codec_type			 = streamvbyte_d1_codec;
+	static const size_t block_size = 1;
+	static const bool   aligned	= false;
+	static std::string  name() { return "streamvbyte"; }
+};
+
+struct maskedvbyte {
+	using codec_type				 = MaskedVByte;
+	using dgap_codec_type			 = codec_type;
+	static const size_t block_size = 1;
+	static const bool   aligned	= false;
+	static std::string  name() { return "maskedvbyte"; }
+};
+
+struct varintg8iu {
+	using codec_type				 = FastPForLib::VarIntG8IU;
+	using dgap_codec_type			 = codec_type;
+	static const size_t block_size = 1;
+	static const bool   aligned	= false;
+	static std::string  name() { return "varintg8iu"; }
+};
+}
+
+// list layout: [payload ints:32][payload][vbyte tail]. the payload holds the
+// largest prefix of the list that is a multiple of the block size and starts
+// on a 128 bit boundary for the block codecs. the codecs pad relative to the
+// absolute address, so the payload is always produced in and decoded from
+// 16 byte aligned memory.
+template <class t_codec, bool t_dgap>
+struct list_simd {
+	using codec_type = typename std::conditional<t_dgap, typename t_codec::dgap_codec_type,
+	typename t_codec::codec_type>::type;
+	// the codec undoes the d-gaps itself
+	static const bool fused_dgap =
+	t_dgap && !std::is_same<typename t_codec::dgap_codec_type, typename t_codec::codec_type>::value;
+
+	static std::string name() { return t_codec::name(); }
+
+	static std::string type() { return t_codec::name() + "(dgap=" + std::to_string(t_dgap) + ")"; }
+
+	static void
+	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t)
+	{
+		static thread_local codec_type			  simd_coder;
+		static thread_local std::vector<uint32_t> tmp;
+		static coder::vbyte_fastpfor			  vcoder;
+		if (t_dgap && !fused_dgap) utils::dgap_list(buf, n);
+
+		size_t num_blocked = n / t_codec::block_size * t_codec::block_size;
+		if (num_blocked) {
+			// every codec stays below 2 ints per input int
+			size_t written_ints = 2 * buf.size() + 1024;
+			tmp.resize(written_ints + 4);
+			auto out32 = aligned(tmp.data());
+			simd_coder.encodeArray(buf.data(), num_blocked, out32, written_ints);
+
+			out.expand_if_needed(256ULL + written_ints * 32ULL);
+			out.align8();
+			out.put_int(written_ints, 32);
+			if (t_codec::aligned) out.align128();
+			memcpy(out.cur_data8(), out32, written_ints * sizeof(uint32_t));
+			out.skip(written_ints * sizeof(uint32_t) * 8);
+		}
+		if (num_blocked != n) vcoder.encode(out, buf.data() + num_blocked, n - num_blocked);
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t)
+	{
+		static thread_local codec_type			  simd_coder;
+		static thread_local std::vector<uint32_t> tmp;
+		static coder::vbyte_fastpfor			  vcoder;
+
+		size_t num_blocked = n / t_codec::block_size * t_codec::block_size;
+		if (num_blocked) {
+			in.align8();
+			size_t input_ints = in.get_int(32);
+			if (t_codec::aligned) in.align128();
+			auto in32 = (const uint32_t*)in.cur_data8();
+			in.skip(input_ints * sizeof(uint32_t) * 8);
+			// copy the payload if it is not aligned (mmapped streams start
+			// after the 8 byte sdsl header) or if the codec could read past
+			// the end of the stream
+			bool misaligned = t_codec::aligned && ((uintptr_t)in32 & 0x0F) != 0;
+			if (misaligned || in.tellg() + 256 > in.size()) {
+				tmp.resize(input_ints + 4 + 64);
+				auto aligned_in = aligned(tmp.data());
+				memcpy(aligned_in, in32, input_ints * sizeof(uint32_t));
+				in32 = aligned_in;
+			}
+			size_t read_ints = num_blocked;
+			simd_coder.decodeArray(in32, input_ints, buf.data(), read_ints);
+		}
+		if (num_blocked != n) vcoder.decode(in, buf.data() + num_blocked, n - num_blocked);
+		if (t_dgap && !fused_dgap) utils::undo_dgap_list(buf, n);
+	}
+
+private:
+	static uint32_t* aligned(uint32_t* ptr) { return (uint32_t*)(((uintptr_t)ptr + 15) & ~(uintptr_t)0x0F); }
+};
+
+template <bool t_dgap>
+using list_simdbp128 = list_simd<simd_codec::bp128, t_dgap>;
+
+template <bool t_dgap>
+using list_simdfastpfor = list_simd<simd_codec::fastpfor, t_dgap>;
+
+template <bool t_dgap>
+using list_streamvbyte = list_simd<simd_codec::streamvbyte, t_dgap>;
+
+template <bool t_dgap>
+using list_maskedvbyte = list_simd<simd_codec::maskedvbyte, t_dgap>;
+
+template <bool t_dgap>
+using list_varintg8iu = list_simd<simd_codec::varintg8iu, t_dgap>;
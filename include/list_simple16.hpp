@@ -28,14 +28,16 @@ struct list_simple16 {
         out.skip(bits_written);
     }
     
-    static void decode(bit_istream<sdsl::bit_vector>& in,std::vector<uint32_t>& buf,size_t n,size_t) {
+    template<class t_bit_istream>
+    static void decode(t_bit_istream& in,std::vector<uint32_t>& buf,size_t n,size_t) {
         static FastPForLib::Simple16<0> s16coder;
         in.align8();
         const uint32_t* in32 = (const uint32_t*) in.cur_data8();
         uint32_t* out = buf.data();
         size_t read_ints = n;
-        s16coder.decodeArray(in32,n,out,read_ints);
-        size_t bits_read = read_ints * sizeof(uint32_t)*8;
+        // decodeArray reports the number of ints written, not read
+        auto in_end = s16coder.decodeArray(in32,n,out,read_ints);
+        size_t bits_read = (in_end - in32) * sizeof(uint32_t)*8;
         in.skip(bits_read);
         if(t_dgap) utils::undo_dgap_list(buf,n);
     }
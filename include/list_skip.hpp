@@ -0,0 +1,334 @@
+#pragma once
+
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+#include "list_cursor.hpp"
+
+// locates the skip table written by list_skip. lists of more than one block
+// are laid out as
+//
+//   [block bits:32][block 0]...[block m-1][offset width:8][offsets][last ids]
+//
+// offsets are relative to the first block, last ids are stored with
+// hi(universe)+1 bits. block b holds doc ids minus (last id of b-1)+1.
+struct skip_table {
+	skip_table() {}
+
+	template <class t_bit_istream>
+	skip_table(const t_bit_istream& is, size_t n, size_t universe, size_t block_size)
+		: m_num_blocks((n + block_size - 1) / block_size), m_id_width(sdsl::bits::hi(universe) + 1)
+	{
+		size_t block_bits = is.get_int(32);
+		m_blocks_start	= is.tellg();
+		is.seek(m_blocks_start + block_bits);
+		m_offset_width  = is.get_int(8);
+		m_offsets_start = m_blocks_start + block_bits + 8;
+		m_ids_start		= m_offsets_start + m_num_blocks * m_offset_width;
+	}
+
+	template <class t_bit_istream>
+	uint64_t offset(const t_bit_istream& is, size_t b) const
+	{
+		is.seek(m_offsets_start + b * m_offset_width);
+		return m_blocks_start + is.get_int(m_offset_width);
+	}
+
+	template <class t_bit_istream>
+	uint32_t last(const t_bit_istream& is, size_t b) const
+	{
+		is.seek(m_ids_start + b * m_id_width);
+		return is.get_int(m_id_width);
+	}
+
+	uint64_t end() const { return m_ids_start + m_num_blocks * m_id_width; }
+
+	size_t   m_num_blocks	= 0;
+	uint8_t  m_id_width		= 0;
+	uint8_t  m_offset_width  = 0;
+	uint64_t m_blocks_start  = 0;
+	uint64_t m_offsets_start = 0;
+	uint64_t m_ids_start	 = 0;
+};
+
+// splits doc id lists longer than t_block_size into blocks that t_list
+// encodes independently and appends a skip table so a cursor can seek to a
+// block and decode only that one. shorter lists are passed to t_list as is.
+// only usable for strictly increasing lists (doc ids). freqs are split by
+// list_skip_freqs.
+template <class t_list, size_t t_block_size = 128>
+struct list_skip {
+	static std::string name() { return t_list::name() + "-skip"; }
+
+	static std::string type()
+	{
+		return t_list::type() + "-skip(" + std::to_string(t_block_size) + ")";
+	}
+
+	static void
+	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		if (n <= t_block_size) {
+			t_list::encode(out, buf, n, universe);
+			return;
+		}
+
+		static thread_local std::vector<uint32_t> tmp;
+		size_t									  num_blocks = (n + t_block_size - 1) / t_block_size;
+		std::vector<uint64_t>					  offsets(num_blocks);
+		std::vector<uint32_t>					  lasts(num_blocks);
+		tmp.resize(t_block_size + 1024);
+
+		auto header = out.tellp();
+		out.put_int(0, 32);
+		auto	 blocks_start = out.tellp();
+		uint32_t base		  = 0;
+		for (size_t b = 0; b < num_blocks; b++) {
+			size_t begin = b * t_block_size;
+			size_t len   = std::min(t_block_size, n - begin);
+			lasts[b]	 = buf[begin + len - 1];
+			for (size_t i = 0; i < len; i++)
+				tmp[i] = buf[begin + i] - base;
+			offsets[b] = out.tellp() - blocks_start;
+			t_list::encode(out, tmp, len, lasts[b] - base + 1);
+			base = lasts[b] + 1;
+		}
+
+		// patch in the size of the blocks and write the table behind them
+		auto blocks_end = out.tellp();
+		out.seek(header);
+		out.put_int(blocks_end - blocks_start, 32);
+		out.seek(blocks_end);
+		uint8_t offset_width = sdsl::bits::hi(offsets.back()) + 1;
+		uint8_t id_width	 = sdsl::bits::hi(universe) + 1;
+		out.put_int(offset_width, 8);
+		out.write_int(offsets.begin(), num_blocks, offset_width);
+		out.write_int(lasts.begin(), num_blocks, id_width);
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		if (n <= t_block_size) {
+			t_list::decode(in, buf, n, universe);
+			return;
+		}
+
+		static thread_local std::vector<uint32_t> tmp;
+		tmp.resize(t_block_size + 1024);
+		skip_table table(in, n, universe, t_block_size);
+		uint32_t   base = 0;
+		for (size_t b = 0; b < table.m_num_blocks; b++) {
+			size_t   begin = b * t_block_size;
+			size_t   len   = std::min(t_block_size, n - begin);
+			uint32_t last  = table.last(in, b);
+			in.seek(table.offset(in, b));
+			t_list::decode(in, tmp, len, last - base + 1);
+			for (size_t i = 0; i < len; i++)
+				buf[begin + i] = tmp[i] + base;
+			base = last + 1;
+		}
+		in.seek(table.end());
+	}
+};
+
+template <class t_list, size_t t_block_size>
+struct list_skip_block_size<list_skip<t_list, t_block_size>> {
+	static constexpr size_t value = t_block_size;
+};
+
+template <class t_list, size_t t_block_size>
+struct list_block_reader<list_skip<t_list, t_block_size>> {
+	list_block_reader(const bit_view& bv, size_t offset, size_t n, size_t universe,
+	const no_list_dictionary* = nullptr)
+		: m_bv(&bv), m_offset(offset), m_n(n), m_universe(universe)
+	{
+		if (n > t_block_size) {
+			bit_istream<bit_view> is(bv);
+			is.seek(offset);
+			m_table = skip_table(is, n, universe, t_block_size);
+		}
+	}
+
+	size_t num_blocks() const { return m_table.m_num_blocks ? m_table.m_num_blocks : 1; }
+
+	size_t block_size() const { return t_block_size; }
+
+	size_t block_begin(size_t b) const { return b * t_block_size; }
+
+	uint32_t block_last(size_t b) const
+	{
+		if (!m_table.m_num_blocks) return m_universe;
+		bit_istream<bit_view> is(*m_bv);
+		return m_table.last(is, b);
+	}
+
+	size_t decode_block(size_t b, std::vector<uint32_t>& out) const
+	{
+		bit_istream<bit_view> is(*m_bv);
+		if (!m_table.m_num_blocks) {
+			is.seek(m_offset);
+			t_list::decode(is, out, m_n, m_universe);
+			return m_n;
+		}
+		size_t   len  = std::min(t_block_size, m_n - b * t_block_size);
+		uint32_t base = b ? m_table.last(is, b - 1) + 1 : 0;
+		uint32_t last = m_table.last(is, b);
+		is.seek(m_table.offset(is, b));
+		t_list::decode(is, out, len, last - base + 1);
+		for (size_t i = 0; i < len; i++)
+			out[i] += base;
+		return len;
+	}
+
+	const bit_view* m_bv;
+	size_t			m_offset;
+	size_t			m_n;
+	size_t			m_universe;
+	skip_table		m_table;
+};
+
+// locates the blocks written by list_skip_freqs. lists of more than one
+// block are laid out as
+//
+//   [block bits:32][block 0]...[block m-1][offset width:8][offsets]
+//
+// offsets are relative to the first block.
+struct block_table {
+	block_table() {}
+
+	template <class t_bit_istream>
+	block_table(const t_bit_istream& is, size_t n, size_t block_size)
+		: m_num_blocks((n + block_size - 1) / block_size)
+	{
+		size_t block_bits = is.get_int(32);
+		m_blocks_start	= is.tellg();
+		is.seek(m_blocks_start + block_bits);
+		m_offset_width  = is.get_int(8);
+		m_offsets_start = m_blocks_start + block_bits + 8;
+	}
+
+	template <class t_bit_istream>
+	uint64_t offset(const t_bit_istream& is, size_t b) const
+	{
+		is.seek(m_offsets_start + b * m_offset_width);
+		return m_blocks_start + is.get_int(m_offset_width);
+	}
+
+	uint64_t end() const { return m_offsets_start + m_num_blocks * m_offset_width; }
+
+	size_t   m_num_blocks	= 0;
+	uint8_t  m_offset_width  = 0;
+	uint64_t m_blocks_start  = 0;
+	uint64_t m_offsets_start = 0;
+};
+
+// the freq list counterpart of list_skip: lists longer than t_block_size are
+// split into blocks that t_list encodes independently, followed by their
+// offsets. a cursor then decodes only the freqs of the block it is in. with
+// the same block size as the doc list the blocks cover the same postings.
+template <class t_list, size_t t_block_size = 128>
+struct list_skip_freqs {
+	static std::string name() { return t_list::name() + "-skipf"; }
+
+	static std::string type()
+	{
+		return t_list::type() + "-skipf(" + std::to_string(t_block_size) + ")";
+	}
+
+	static void
+	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		if (n <= t_block_size) {
+			t_list::encode(out, buf, n, universe);
+			return;
+		}
+
+		static thread_local std::vector<uint32_t> tmp;
+		size_t									  num_blocks = (n + t_block_size - 1) / t_block_size;
+		std::vector<uint64_t>					  offsets(num_blocks);
+		tmp.resize(t_block_size + 1024);
+
+		auto header = out.tellp();
+		out.put_int(0, 32);
+		auto blocks_start = out.tellp();
+		for (size_t b = 0; b < num_blocks; b++) {
+			size_t begin = b * t_block_size;
+			size_t len   = std::min(t_block_size, n - begin);
+			std::copy(buf.begin() + begin, buf.begin() + begin + len, tmp.begin());
+			offsets[b] = out.tellp() - blocks_start;
+			t_list::encode(out, tmp, len, universe);
+		}
+
+		// patch in the size of the blocks and write the offsets behind them
+		auto blocks_end = out.tellp();
+		out.seek(header);
+		out.put_int(blocks_end - blocks_start, 32);
+		out.seek(blocks_end);
+		uint8_t offset_width = sdsl::bits::hi(offsets.back()) + 1;
+		out.put_int(offset_width, 8);
+		out.write_int(offsets.begin(), num_blocks, offset_width);
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		if (n <= t_block_size) {
+			t_list::decode(in, buf, n, universe);
+			return;
+		}
+
+		static thread_local std::vector<uint32_t> tmp;
+		tmp.resize(t_block_size + 1024);
+		block_table table(in, n, t_block_size);
+		for (size_t b = 0; b < table.m_num_blocks; b++) {
+			size_t begin = b * t_block_size;
+			size_t len   = std::min(t_block_size, n - begin);
+			in.seek(table.offset(in, b));
+			t_list::decode(in, tmp, len, universe);
+			std::copy(tmp.begin(), tmp.begin() + len, buf.begin() + begin);
+		}
+		in.seek(table.end());
+	}
+};
+
+template <class t_list, size_t t_block_size>
+struct list_block_reader<list_skip_freqs<t_list, t_block_size>> {
+	list_block_reader(const bit_view& bv, size_t offset, size_t n, size_t universe,
+	const no_list_dictionary* = nullptr)
+		: m_bv(&bv), m_offset(offset), m_n(n), m_universe(universe)
+	{
+		if (n > t_block_size) {
+			bit_istream<bit_view> is(bv);
+			is.seek(offset);
+			m_table = block_table(is, n, t_block_size);
+		}
+	}
+
+	size_t num_blocks() const { return m_table.m_num_blocks ? m_table.m_num_blocks : 1; }
+
+	size_t block_size() const { return t_block_size; }
+
+	size_t block_begin(size_t b) const { return b * t_block_size; }
+
+	uint32_t block_last(size_t) const { return m_universe; }
+
+	size_t decode_block(size_t b, std::vector<uint32_t>& out) const
+	{
+		bit_istream<bit_view> is(*m_bv);
+		if (!m_table.m_num_blocks) {
+			is.seek(m_offset);
+			t_list::decode(is, out, m_n, m_universe);
+			return m_n;
+		}
+		size_t len = std::min(t_block_size, m_n - b * t_block_size);
+		is.seek(m_table.offset(is, b));
+		t_list::decode(is, out, len, m_universe);
+		return len;
+	}
+
+	const bit_view* m_bv;
+	size_t			m_offset;
+	size_t			m_n;
+	size_t			m_universe;
+	block_table		m_table;
+};
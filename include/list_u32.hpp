@@ -19,9 +19,16 @@ struct list_u32 {
         u32coder.encode(out,buf.data(),n);
     }
     
-    static void decode(bit_istream<sdsl::bit_vector>& in,std::vector<uint32_t>& buf,size_t n,size_t) {
+    template<class t_bit_istream>
+    static void decode(t_bit_istream& in,std::vector<uint32_t>& buf,size_t n,size_t) {
         static coder::aligned_fixed<uint32_t> u32coder;
-        u32coder.decode(in,buf.data(),n);
-        if(t_dgap) utils::undo_dgap_list(buf,n);
+        if(t_dgap) {
+            // sum up the gaps while copying them out of the stream
+            in.align8();
+            utils::prefix_sum((const uint32_t*)in.cur_data8(),buf.data(),n);
+            in.skip(sizeof(uint32_t)*8*n);
+        } else {
+            u32coder.decode(in,buf.data(),n);
+        }
     }
 };
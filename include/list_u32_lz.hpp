@@ -25,22 +25,23 @@ struct list_u32_lz {
         
         // (1) entropy encode the u32 encoded data
         const uint32_t* u32_data = (const uint32_t*) buf.data(); 
-        static t_ent_coder ent_coder;
+        static thread_local t_ent_coder ent_coder;
         ent_coder.encode(out,u32_data,n);
     }
     
-    static void decode(bit_istream<sdsl::bit_vector>& in,std::vector<uint32_t>& buf,size_t n,size_t) {
+    template<class t_bit_istream>
+    static void decode(t_bit_istream& in,std::vector<uint32_t>& buf,size_t n,size_t) {
         // (0) small lists remain vbyte only
         if(n <= t_thres) {
             static coder::vbyte_fastpfor vcoder;
-            vcoder.decode(in,buf.data(),n);
-            if(t_dgap) utils::undo_dgap_list(buf,n);
+            if(t_dgap) vcoder.decode_dgap(in,buf.data(),n);
+            else vcoder.decode(in,buf.data(),n);
             return;
         }
         
         // (1) undo the entropy coder
         uint32_t* u32_data = (uint32_t*) buf.data();
-        static t_ent_coder ent_coder;
+        static thread_local t_ent_coder ent_coder;
         ent_coder.decode(in,u32_data,n);
         
         if(t_dgap) utils::undo_dgap_list(buf,n);
@@ -19,9 +19,10 @@ struct list_vbyte {
         vcoder.encode(out,buf.data(),n);
     }
     
-    static void decode(bit_istream<sdsl::bit_vector>& in,std::vector<uint32_t>& buf,size_t n,size_t) {
+    template<class t_bit_istream>
+    static void decode(t_bit_istream& in,std::vector<uint32_t>& buf,size_t n,size_t) {
         static coder::vbyte_fastpfor vcoder;
-        vcoder.decode(in,buf.data(),n);
-        if(t_dgap) utils::undo_dgap_list(buf,n);
+        if(t_dgap) vcoder.decode_dgap(in,buf.data(),n);
+        else vcoder.decode(in,buf.data(),n);
     }
 };
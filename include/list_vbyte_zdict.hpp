@@ -0,0 +1,246 @@
+#pragma once
+
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+#include "list_dictionary.hpp"
+#include "utils.hpp"
+
+#include "dictBuilder/zdict.h"
+#include "zstd.h"
+
+#include <cstring>
+
+// list_vbyte_lz with zstd primed by a dictionary trained on the vbyte encoded
+// lists of the index. short lists compress well with the dictionary as
+// context, and every list can still be decoded on its own. the dictionary is
+// owned by the index and passed to encode and decode (see list_dictionary).
+// without one the lists are compressed with plain zstd.
+//
+// dictionary layout: [bytes:32][dictionary bytes]
+template <bool t_dgap, size_t t_thres, uint8_t t_level>
+struct list_vbyte_zdict {
+	using ent_coder_type = coder::zstd_dict<t_level>;
+
+	static const size_t dict_bytes	 = 64 * 1024;
+	static const size_t sample_bytes = 4 * 1024;
+
+	static std::string name() { return "vbyte-" + ent_coder_type::type(); }
+
+	static std::string type()
+	{
+		return "vbyte(dgap=" + std::to_string(t_dgap) + "-" + std::to_string(t_thres) + "-" +
+			   ent_coder_type::type() + ")";
+	}
+
+	// the dictionary and the zstd structures prepared from it. the prepared
+	// dictionaries are read only and shared by the coders of all threads.
+	struct dictionary_state {
+		std::vector<uint8_t> dict;
+		ZSTD_CDict*			 cdict = nullptr;
+		ZSTD_DDict*			 ddict = nullptr;
+
+		dictionary_state() = default;
+		dictionary_state(const dictionary_state&) = delete;
+		dictionary_state& operator=(const dictionary_state&) = delete;
+
+		void reset(std::vector<uint8_t> d)
+		{
+			release();
+			dict = std::move(d);
+			if (dict.empty()) return;
+			// parameters for unknown source sizes produce corrupt frames
+			// with dictionaries in this zstd version, so give a size hint
+			ZSTD_parameters params = ZSTD_getParams(t_level, 128 * 1024, dict.size());
+			// the list length is known and there is only one dictionary
+			params.fParams.contentSizeFlag = 0;
+			params.fParams.noDictIDFlag	= 1;
+			ZSTD_customMem const cmem	  = {NULL, NULL, NULL};
+			cdict = ZSTD_createCDict_advanced(dict.data(), dict.size(), params, cmem);
+			ddict = ZSTD_createDDict(dict.data(), dict.size());
+		}
+
+		void release()
+		{
+			ZSTD_freeCDict(cdict);
+			ZSTD_freeDDict(ddict);
+			cdict = nullptr;
+			ddict = nullptr;
+		}
+
+		~dictionary_state() { release(); }
+	};
+
+	static const dictionary_state& no_dictionary()
+	{
+		static const dictionary_state state;
+		return state;
+	}
+
+	// train on the first sample_bytes of the vbyte encoding of evenly spaced
+	// lists, about 100 times the dictionary size in total
+	template <class t_lists>
+	static void train_dictionary(dictionary_state& state, const t_lists& lists)
+	{
+		size_t num_eligible = 0;
+		for (const auto& l : lists)
+			if (l.size() > t_thres) num_eligible++;
+		size_t max_samples = 100 * dict_bytes / sample_bytes;
+		size_t step		   = std::max(size_t(1), num_eligible / max_samples);
+
+		std::vector<uint8_t>  samples;
+		std::vector<size_t>   sample_sizes;
+		std::vector<uint32_t> buf;
+		size_t				  cur = 0;
+		for (const auto& l : lists) {
+			if (l.size() <= t_thres) continue;
+			if (cur++ % step != 0) continue;
+			buf.assign(l.begin(), l.end());
+			if (t_dgap) utils::dgap_list(buf, buf.size());
+			sdsl::bit_vector tmp;
+			vbyte_encode(tmp, buf, buf.size());
+			size_t bytes = std::min(tmp.size() / 8, sample_bytes);
+			samples.insert(samples.end(), (const uint8_t*)tmp.data(), (const uint8_t*)tmp.data() + bytes);
+			sample_sizes.push_back(bytes);
+		}
+
+		std::vector<uint8_t> dict(dict_bytes);
+		size_t				 size = 0;
+		if (!sample_sizes.empty()) {
+			size = ZDICT_trainFromBuffer(dict.data(), dict.size(), samples.data(), sample_sizes.data(),
+			sample_sizes.size());
+		}
+		if (sample_sizes.empty() || ZDICT_isError(size)) {
+			LOG(INFO) << "no zstd dictionary trained, compressing lists without one";
+			size = 0;
+		}
+		dict.resize(size);
+		state.reset(std::move(dict));
+	}
+
+	static void write_dictionary(bit_ostream<sdsl::bit_vector>& out, const dictionary_state& state)
+	{
+		const auto& dict = state.dict;
+		out.expand_if_needed(64 + dict.size() * 8ULL);
+		out.put_int(dict.size(), 32);
+		out.align8();
+		memcpy(out.cur_data8(), dict.data(), dict.size());
+		out.skip(dict.size() * 8ULL);
+	}
+
+	template <class t_bit_istream>
+	static void read_dictionary(t_bit_istream& in, dictionary_state& state)
+	{
+		size_t size = in.get_int(32);
+		in.align8();
+		const uint8_t* data = in.cur_data8();
+		state.reset(std::vector<uint8_t>(data, data + size));
+		in.skip(size * 8ULL);
+	}
+
+	static void
+	encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		encode(out, buf, n, universe, no_dictionary());
+	}
+
+	static void encode(bit_ostream<sdsl::bit_vector>& out, std::vector<uint32_t>& buf, size_t n, size_t,
+	const dictionary_state& state)
+	{
+		static coder::vbyte_fastpfor vcoder;
+		if (t_dgap) utils::dgap_list(buf, n);
+
+		// (0) small lists remain vbyte only
+		if (n <= t_thres) {
+			vcoder.encode(out, buf.data(), n);
+			return;
+		}
+
+		// (1) vbyte encode stuff
+		sdsl::bit_vector tmp;
+		vbyte_encode(tmp, buf, n);
+
+		// (2) compress the vbyte encoded data with the dictionary. lists
+		// zstd does not shrink are stored as plain vbyte behind a zero length.
+		size_t num_u32 = tmp.size() / 32;
+		auto   start   = out.tellp();
+		out.put_int(num_u32, 32);
+		const uint32_t* vbyte_data = (const uint32_t*)tmp.data();
+		if (state.cdict == nullptr) {
+			static thread_local coder::zstd<t_level> plain_coder;
+			plain_coder.encode(out, vbyte_data, num_u32);
+		} else {
+			static thread_local ent_coder_type ent_coder;
+			ent_coder.set_cdict(state.cdict);
+			ent_coder.encode(out, vbyte_data, num_u32);
+		}
+		if (out.tellp() - start >= 64 + tmp.size()) {
+			out.seek(start);
+			out.put_int(0, 32);
+			vcoder.encode(out, buf.data(), n);
+		}
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t universe)
+	{
+		decode(in, buf, n, universe, no_dictionary());
+	}
+
+	template <class t_bit_istream>
+	static void decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n, size_t,
+	const dictionary_state& state)
+	{
+		// (0) small lists remain vbyte only
+		if (n <= t_thres) {
+			vbyte_decode(in, buf, n);
+			return;
+		}
+
+		// (1) undo the dictionary compression
+		size_t num_u32 = in.get_int(32);
+		if (num_u32 == 0) {
+			vbyte_decode(in, buf, n);
+			return;
+		}
+		auto&	 tmp		= utils::thread_scratch(num_u32);
+		uint32_t* vbyte_data = (uint32_t*)tmp.data();
+		if (state.ddict == nullptr) {
+			static thread_local coder::zstd<t_level> plain_coder;
+			plain_coder.decode(in, vbyte_data, num_u32);
+		} else {
+			static thread_local ent_coder_type ent_coder;
+			ent_coder.set_ddict(state.ddict);
+			ent_coder.decode(in, vbyte_data, num_u32);
+		}
+
+		// (2) undo the vbyte
+		bit_istream<sdsl::bit_vector> tmpfs(tmp);
+		vbyte_decode(tmpfs, buf, n);
+	}
+
+private:
+	// the d-gaps are summed up while decoding
+	template <class t_bit_istream>
+	static void vbyte_decode(t_bit_istream& in, std::vector<uint32_t>& buf, size_t n)
+	{
+		static coder::vbyte_fastpfor vcoder;
+		if (t_dgap)
+			vcoder.decode_dgap(in, buf.data(), n);
+		else
+			vcoder.decode(in, buf.data(), n);
+	}
+
+	static void vbyte_encode(sdsl::bit_vector& tmp, std::vector<uint32_t>& buf, size_t n)
+	{
+		static coder::vbyte_fastpfor vcoder;
+		{
+			bit_ostream<sdsl::bit_vector> tmpfs(tmp);
+			vcoder.encode(tmpfs, buf.data(), n);
+		}
+		if (tmp.size() % 32 != 0) {
+			size_t add = 32 - (tmp.size() % 32);
+			tmp.resize(tmp.size() + add);
+			LOG(ERROR) << "encoding error!";
+		}
+	}
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "sdsl/io.hpp"
+#include "sdsl/int_vector.hpp"
 
 struct list_meta_data {
     using size_type = uint64_t;
@@ -9,6 +10,7 @@ struct list_meta_data {
     uint64_t freq_offset = 0;
     uint32_t list_len = 0; // list len
     uint32_t Ft = 0; // sum of freqs
+    float max_score = 0; // max bm25 score of any posting in the list
     
     inline size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = NULL, std::string name = "") const
     {
@@ -19,6 +21,7 @@ struct list_meta_data {
         written_bytes += sdsl::serialize(freq_offset,out,child,"freq_offset");
         written_bytes += sdsl::serialize(list_len,out,child,"list_len");
         written_bytes += sdsl::serialize(Ft,out,child,"Ft");
+        written_bytes += sdsl::serialize(max_score,out,child,"max_score");
         sdsl::structure_tree::add_size(child, written_bytes);
         return written_bytes;
     }
@@ -29,6 +32,7 @@ struct list_meta_data {
         sdsl::load(freq_offset,in);
         sdsl::load(list_len,in);
         sdsl::load(Ft,in);
+        sdsl::load(max_score,in);
     }
 };
 
@@ -37,6 +41,7 @@ struct meta_data {
     uint64_t m_num_postings = 0;
     uint64_t m_num_docs = 0;
     uint64_t m_num_lists = 0;
+    double m_avg_doc_len = 0;
     std::vector<list_meta_data> m_list_data;
     
     inline size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = NULL, std::string name = "") const
@@ -47,6 +52,7 @@ struct meta_data {
         written_bytes += sdsl::serialize(m_num_postings,out,child,"num_postings");
         written_bytes += sdsl::serialize(m_num_docs,out,child,"num_docs");
         written_bytes += sdsl::serialize(m_num_lists,out,child,"num_lists");
+        written_bytes += sdsl::serialize(m_avg_doc_len,out,child,"avg_doc_len");
         for(size_t i=0;i<m_num_lists;i++) {
             written_bytes += sdsl::serialize(m_list_data[i],out,child,"list_data");
         }
@@ -59,6 +65,7 @@ struct meta_data {
         sdsl::load(m_num_postings,in);
         sdsl::load(m_num_docs,in);
         sdsl::load(m_num_lists,in);
+        sdsl::load(m_avg_doc_len,in);
         m_list_data.resize(m_num_lists);
         for(size_t i=0;i<m_num_lists;i++) {
             sdsl::load(m_list_data[i],in);
@@ -67,3 +74,41 @@ struct meta_data {
 };
 
 
+
+// per block score bounds for block-max query processing. block i of list l is
+// entry m_block_start[l]+i. lists that fit in one block get a single entry.
+// impacts are bm25 scores quantized to 8 bits relative to the list max_score
+// and rounded up so they stay upper bounds.
+struct block_max_data {
+    using size_type = uint64_t;
+    uint64_t m_block_size = 0;
+    sdsl::int_vector<> m_block_start;
+    sdsl::int_vector<> m_max_tf;
+    sdsl::int_vector<8> m_max_impact;
+
+    size_t num_blocks(uint64_t list_len) const {
+        if(m_block_size == 0 || list_len <= m_block_size) return 1;
+        return (list_len + m_block_size - 1) / m_block_size;
+    }
+
+    inline size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = NULL, std::string name = "") const
+    {
+        using namespace sdsl;
+        structure_tree_node* child = structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+        size_type written_bytes = 0;
+        written_bytes += sdsl::serialize(m_block_size,out,child,"block_size");
+        written_bytes += m_block_start.serialize(out,child,"block_start");
+        written_bytes += m_max_tf.serialize(out,child,"max_tf");
+        written_bytes += m_max_impact.serialize(out,child,"max_impact");
+        sdsl::structure_tree::add_size(child, written_bytes);
+        return written_bytes;
+    }
+
+    inline void load(std::istream& in)
+    {
+        sdsl::load(m_block_size,in);
+        m_block_start.load(in);
+        m_max_tf.load(in);
+        m_max_impact.load(in);
+    }
+};
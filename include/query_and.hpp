@@ -0,0 +1,243 @@
+#pragma once
+
+#include "inverted_index.hpp"
+
+#include <algorithm>
+#include <immintrin.h>
+
+// intersection kernels over sorted duplicate free doc id arrays. apply()
+// writes the elements common to a and b to out and returns their number.
+// out must not alias a or b and needs 8 elements of slack behind
+// min(na,nb) as the simd kernels store whole registers.
+namespace intersect {
+
+struct merge {
+	static std::string name() { return "merge"; }
+
+	static size_t apply(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out)
+	{
+		size_t i = 0, j = 0, k = 0;
+		while (i < na && j < nb) {
+			if (a[i] < b[j]) {
+				i++;
+			} else if (a[i] > b[j]) {
+				j++;
+			} else {
+				out[k++] = a[i];
+				i++;
+				j++;
+			}
+		}
+		return k;
+	}
+};
+
+// exponential search for each element of the shorter list in the longer one.
+// wins when the list lengths differ a lot.
+struct galloping {
+	static std::string name() { return "galloping"; }
+
+	static size_t apply(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out)
+	{
+		if (na > nb) {
+			std::swap(a, b);
+			std::swap(na, nb);
+		}
+		size_t j = 0, k = 0;
+		for (size_t i = 0; i < na && j < nb; i++) {
+			uint32_t x = a[i];
+			if (b[j] < x) {
+				size_t bound = 1;
+				while (j + bound < nb && b[j + bound] < x)
+					bound *= 2;
+				auto lo = b + j + bound / 2 + 1;
+				auto hi = b + std::min(j + bound + 1, nb);
+				j		= std::lower_bound(lo, hi, x) - b;
+				if (j == nb) break;
+			}
+			if (b[j] == x) {
+				out[k++] = x;
+				j++;
+			}
+		}
+		return k;
+	}
+};
+
+// compares blocks of 4x4 ints with all rotations of b (Katsov's shuffling
+// algorithm) and compacts the matches with pshufb.
+struct simd_sse {
+	static std::string name() { return "sse"; }
+
+	struct shuffle_table {
+		uint8_t masks[16][16];
+		shuffle_table()
+		{
+			for (size_t m = 0; m < 16; m++) {
+				size_t k = 0;
+				for (size_t i = 0; i < 4; i++) {
+					if (m & (1 << i)) {
+						for (size_t b = 0; b < 4; b++)
+							masks[m][k++] = 4 * i + b;
+					}
+				}
+				while (k < 16)
+					masks[m][k++] = 0x80;
+			}
+		}
+	};
+
+	static size_t apply(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out)
+	{
+		static const shuffle_table table;
+		size_t					   i = 0, j = 0, k = 0;
+		size_t					   na4 = na & ~size_t(3);
+		size_t					   nb4 = nb & ~size_t(3);
+		while (i < na4 && j < nb4) {
+			__m128i  va   = _mm_loadu_si128((const __m128i*)(a + i));
+			__m128i  vb   = _mm_loadu_si128((const __m128i*)(b + j));
+			uint32_t amax = a[i + 3];
+			uint32_t bmax = b[j + 3];
+			__m128i  m0   = _mm_cmpeq_epi32(va, vb);
+			__m128i  m1   = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)));
+			__m128i  m2   = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2)));
+			__m128i  m3   = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)));
+			__m128i  m	= _mm_or_si128(_mm_or_si128(m0, m1), _mm_or_si128(m2, m3));
+			int		 mask = _mm_movemask_ps(_mm_castsi128_ps(m));
+			__m128i  shuf = _mm_loadu_si128((const __m128i*)table.masks[mask]);
+			_mm_storeu_si128((__m128i*)(out + k), _mm_shuffle_epi8(va, shuf));
+			k += __builtin_popcount(mask);
+			if (amax <= bmax) i += 4;
+			if (amax >= bmax) j += 4;
+		}
+		return k + merge::apply(a + i, na - i, b + j, nb - j, out + k);
+	}
+};
+
+// the same idea on 8x8 blocks. compiled for avx2 independent of the global
+// flags; callers check supported() before using it.
+struct simd_avx2 {
+	static std::string name() { return "avx2"; }
+
+	static bool supported() { return __builtin_cpu_supports("avx2"); }
+
+	struct permute_table {
+		uint32_t perms[256][8];
+		permute_table()
+		{
+			for (size_t m = 0; m < 256; m++) {
+				size_t k = 0;
+				for (size_t i = 0; i < 8; i++) {
+					if (m & (1 << i)) perms[m][k++] = i;
+				}
+				while (k < 8)
+					perms[m][k++] = 0;
+			}
+		}
+	};
+
+	__attribute__((target("avx2"))) static size_t
+	apply(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out)
+	{
+		static const permute_table table;
+		size_t					   i = 0, j = 0, k = 0;
+		size_t					   na8 = na & ~size_t(7);
+		size_t					   nb8 = nb & ~size_t(7);
+		const __m256i			   rot = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+		while (i < na8 && j < nb8) {
+			__m256i  va   = _mm256_loadu_si256((const __m256i*)(a + i));
+			__m256i  vb   = _mm256_loadu_si256((const __m256i*)(b + j));
+			uint32_t amax = a[i + 7];
+			uint32_t bmax = b[j + 7];
+			__m256i  m	= _mm256_cmpeq_epi32(va, vb);
+			for (size_t r = 1; r < 8; r++) {
+				vb = _mm256_permutevar8x32_epi32(vb, rot);
+				m  = _mm256_or_si256(m, _mm256_cmpeq_epi32(va, vb));
+			}
+			int		mask = _mm256_movemask_ps(_mm256_castsi256_ps(m));
+			__m256i perm = _mm256_loadu_si256((const __m256i*)table.perms[mask]);
+			_mm256_storeu_si256((__m256i*)(out + k), _mm256_permutevar8x32_epi32(va, perm));
+			k += __builtin_popcount(mask);
+			if (amax <= bmax) i += 8;
+			if (amax >= bmax) j += 8;
+		}
+		return k + merge::apply(a + i, na - i, b + j, nb - j, out + k);
+	}
+};
+
+// pick galloping for skewed list lengths and t_kernel otherwise
+template <class t_kernel, size_t t_ratio = 32>
+struct adaptive {
+	static std::string name() { return "adaptive-" + t_kernel::name(); }
+
+	static size_t apply(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out)
+	{
+		if (na * t_ratio < nb || nb * t_ratio < na) return galloping::apply(a, na, b, nb, out);
+		return t_kernel::apply(a, na, b, nb, out);
+	}
+};
+}
+
+// set-versus-set AND: decode the doc ids of the terms shortest list first and
+// intersect the running result with each following list. term ids are list
+// ids of the index. returns the number of matching doc ids stored in result.
+template <class t_intersect, class t_index>
+size_t and_query_svs(const t_index& index, std::vector<uint64_t> terms, std::vector<uint32_t>& result)
+{
+	result.clear();
+	if (terms.empty()) return 0;
+	std::sort(terms.begin(), terms.end(), [&index](uint64_t x, uint64_t y) {
+		return index.list_len(x) < index.list_len(y);
+	});
+
+	static thread_local std::vector<uint32_t> tmp;
+	auto&									  list = list_scratch::get();
+	index.decode_docs_into(terms[0], list);
+	size_t n = list.list_len;
+	result.resize(n + 8);
+	std::copy(list.doc_ids.begin(), list.doc_ids.begin() + n, result.begin());
+	for (size_t i = 1; i < terms.size() && n != 0; i++) {
+		index.decode_docs_into(terms[i], list);
+		tmp.resize(n + 8);
+		n = t_intersect::apply(result.data(), n, list.doc_ids.data(), list.list_len, tmp.data());
+		std::swap(result, tmp);
+	}
+	result.resize(n);
+	return n;
+}
+
+// document-at-a-time AND over list cursors. lists with skip tables only
+// decode the blocks that can contain a candidate.
+template <class t_index>
+size_t and_query_cursor(const t_index& index, std::vector<uint64_t> terms, std::vector<uint32_t>& result)
+{
+	using cursor_type = decltype(index.cursor(0));
+	result.clear();
+	if (terms.empty()) return 0;
+	std::sort(terms.begin(), terms.end(), [&index](uint64_t x, uint64_t y) {
+		return index.list_len(x) < index.list_len(y);
+	});
+
+	std::vector<cursor_type> cursors;
+	cursors.reserve(terms.size());
+	for (auto t : terms)
+		cursors.emplace_back(index.cursor(t));
+
+	uint32_t candidate = cursors[0].docid();
+	size_t   i		   = 1;
+	while (candidate != cursor_type::end_docid) {
+		for (; i < cursors.size(); i++) {
+			cursors[i].next_geq(candidate);
+			if (cursors[i].docid() != candidate) break;
+		}
+		if (i == cursors.size()) {
+			result.push_back(candidate);
+			cursors[0].next();
+		} else {
+			cursors[0].next_geq(cursors[i].docid());
+		}
+		candidate = cursors[0].docid();
+		i		  = 1;
+	}
+	return result.size();
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+#include "inverted_index.hpp"
+#include "rankers.hpp"
+
+#include <algorithm>
+
+struct doc_score {
+	uint32_t id;
+	double   score;
+};
+
+// the k best scored documents seen so far kept in a min heap
+struct topk_queue {
+	explicit topk_queue(size_t k) : m_k(k) { m_heap.reserve(k + 1); }
+
+	// score a document has to beat to enter the top-k
+	double threshold() const { return m_heap.size() < m_k ? 0.0 : m_heap.front().score; }
+
+	// returns true if the document made it into the top-k
+	bool insert(uint32_t id, double score)
+	{
+		if (m_heap.size() == m_k) {
+			if (score <= m_heap.front().score) return false;
+			std::pop_heap(m_heap.begin(), m_heap.end(), cmp);
+			m_heap.pop_back();
+		}
+		m_heap.push_back({id, score});
+		std::push_heap(m_heap.begin(), m_heap.end(), cmp);
+		return true;
+	}
+
+	// results by decreasing score
+	void finalize(std::vector<doc_score>& result)
+	{
+		std::sort_heap(m_heap.begin(), m_heap.end(), cmp);
+		result.swap(m_heap);
+		m_heap.clear();
+	}
+
+	static bool cmp(const doc_score& a, const doc_score& b) { return a.score > b.score; }
+
+	size_t				   m_k;
+	std::vector<doc_score> m_heap;
+};
+
+// a query term: its cursor plus what is needed to score its postings
+template <class t_index>
+struct scored_cursor {
+	using cursor_type = decltype(std::declval<const t_index&>().cursor(0));
+
+	scored_cursor(const t_index& index, uint64_t term)
+		: cursor(index.cursor(term))
+		, term(term)
+		, idf(bm25::idf(index.num_docs(), index.list_len(term)))
+		, max_score(index.max_score(term))
+	{
+	}
+
+	double score(const t_index& index)
+	{
+		return bm25::score(idf, cursor.freq(), index.doc_len(cursor.docid()), index.avg_doc_len());
+	}
+
+	cursor_type cursor;
+	uint64_t	term;
+	double		idf;
+	double		max_score;
+};
+
+template <class t_index>
+std::vector<scored_cursor<t_index>> open_cursors(const t_index& index, const std::vector<uint64_t>& terms)
+{
+	std::vector<scored_cursor<t_index>> cursors;
+	cursors.reserve(terms.size());
+	for (auto t : terms)
+		cursors.emplace_back(index, t);
+	return cursors;
+}
+
+// exhaustive document-at-a-time ranked OR. scores every matching document
+// and is the reference the pruning strategies are checked against.
+template <class t_index>
+size_t topk_query_or(const t_index& index, const std::vector<uint64_t>& terms, size_t k,
+std::vector<doc_score>& result)
+{
+	using cursor_type = typename scored_cursor<t_index>::cursor_type;
+	auto	   cursors = open_cursors(index, terms);
+	topk_queue topk(k);
+
+	uint32_t cur = cursor_type::end_docid;
+	for (auto& c : cursors)
+		cur = std::min(cur, c.cursor.docid());
+	while (cur != cursor_type::end_docid) {
+		double   score = 0;
+		uint32_t next  = cursor_type::end_docid;
+		for (auto& c : cursors) {
+			if (c.cursor.docid() == cur) {
+				score += c.score(index);
+				c.cursor.next();
+			}
+			next = std::min(next, c.cursor.docid());
+		}
+		topk.insert(cur, score);
+		cur = next;
+	}
+	topk.finalize(result);
+	return result.size();
+}
+
+// WAND (Broder et al. 2003). keeps the cursors ordered by doc id and only
+// scores a document once the bounds of the lists up to it can beat the
+// current top-k threshold. lists before that pivot are moved forward.
+template <class t_index>
+size_t topk_query_wand(const t_index& index, const std::vector<uint64_t>& terms, size_t k,
+std::vector<doc_score>& result)
+{
+	using cursor_type = typename scored_cursor<t_index>::cursor_type;
+	auto	   cursors = open_cursors(index, terms);
+	topk_queue topk(k);
+
+	std::vector<scored_cursor<t_index>*> ordered;
+	for (auto& c : cursors)
+		ordered.push_back(&c);
+	auto by_docid = [](const scored_cursor<t_index>* a, const scored_cursor<t_index>* b) {
+		return a->cursor.docid() < b->cursor.docid();
+	};
+	std::sort(ordered.begin(), ordered.end(), by_docid);
+
+	while (true) {
+		double threshold = topk.threshold();
+		double bound	 = 0;
+		size_t pivot	 = 0;
+		for (; pivot < ordered.size(); pivot++) {
+			if (ordered[pivot]->cursor.docid() == cursor_type::end_docid) break;
+			bound += ordered[pivot]->max_score;
+			if (bound > threshold) break;
+		}
+		if (pivot == ordered.size() || ordered[pivot]->cursor.docid() == cursor_type::end_docid) {
+			break;
+		}
+
+		uint32_t pivot_id = ordered[pivot]->cursor.docid();
+		if (ordered[0]->cursor.docid() == pivot_id) {
+			double score = 0;
+			for (auto c : ordered) {
+				if (c->cursor.docid() != pivot_id) break;
+				score += c->score(index);
+				c->cursor.next();
+			}
+			topk.insert(pivot_id, score);
+		} else {
+			for (size_t i = 0; i < pivot; i++) {
+				if (ordered[i]->cursor.docid() < pivot_id) ordered[i]->cursor.next_geq(pivot_id);
+			}
+		}
+		std::sort(ordered.begin(), ordered.end(), by_docid);
+	}
+	topk.finalize(result);
+	return result.size();
+}
+
+// Block-Max WAND (Ding and Suel 2011). picks the pivot like WAND, then
+// checks it against the block bounds of the lists up to the pivot. if those
+// cannot beat the threshold either, skips past the first of the blocks to
+// end instead of scoring. without skip tables every list is a single block
+// and this is plain WAND.
+template <class t_index>
+size_t topk_query_bmw(const t_index& index, const std::vector<uint64_t>& terms, size_t k,
+std::vector<doc_score>& result)
+{
+	using cursor_type = typename scored_cursor<t_index>::cursor_type;
+	auto	   cursors = open_cursors(index, terms);
+	topk_queue topk(k);
+
+	std::vector<scored_cursor<t_index>*> ordered;
+	for (auto& c : cursors)
+		ordered.push_back(&c);
+	auto by_docid = [](const scored_cursor<t_index>* a, const scored_cursor<t_index>* b) {
+		return a->cursor.docid() < b->cursor.docid();
+	};
+	std::sort(ordered.begin(), ordered.end(), by_docid);
+
+	while (true) {
+		double threshold = topk.threshold();
+		double bound	 = 0;
+		size_t pivot	 = 0;
+		for (; pivot < ordered.size(); pivot++) {
+			if (ordered[pivot]->cursor.docid() == cursor_type::end_docid) break;
+			bound += ordered[pivot]->max_score;
+			if (bound > threshold) break;
+		}
+		if (pivot == ordered.size() || ordered[pivot]->cursor.docid() == cursor_type::end_docid) {
+			break;
+		}
+		// lists on the pivot document all contribute to its score
+		uint32_t pivot_id = ordered[pivot]->cursor.docid();
+		while (pivot + 1 < ordered.size() && ordered[pivot + 1]->cursor.docid() == pivot_id)
+			pivot++;
+
+		double block_bound = 0;
+		for (size_t i = 0; i <= pivot; i++) {
+			auto c = ordered[i];
+			c->cursor.next_shallow(pivot_id);
+			block_bound += index.block_max_score(c->term, c->cursor.shallow_block());
+		}
+
+		if (block_bound > threshold) {
+			if (ordered[0]->cursor.docid() == pivot_id) {
+				double score = 0;
+				for (auto c : ordered) {
+					if (c->cursor.docid() != pivot_id) break;
+					score += c->score(index);
+					c->cursor.next();
+				}
+				topk.insert(pivot_id, score);
+			} else {
+				for (size_t i = 0; i < pivot; i++) {
+					if (ordered[i]->cursor.docid() < pivot_id) ordered[i]->cursor.next_geq(pivot_id);
+				}
+			}
+		} else {
+			// no document before the end of the first block or the next list
+			// can make it, move the list with the highest bound there
+			uint32_t next = cursor_type::end_docid;
+			if (pivot + 1 < ordered.size()) next = ordered[pivot + 1]->cursor.docid();
+			size_t advance = 0;
+			for (size_t i = 0; i <= pivot; i++) {
+				uint32_t last = ordered[i]->cursor.shallow_last();
+				if (last != cursor_type::end_docid) next = std::min(next, last + 1);
+				if (ordered[i]->max_score > ordered[advance]->max_score) advance = i;
+			}
+			if (next <= pivot_id) next = pivot_id + 1;
+			ordered[advance]->cursor.next_geq(next);
+		}
+		std::sort(ordered.begin(), ordered.end(), by_docid);
+	}
+	topk.finalize(result);
+	return result.size();
+}
+
+// MaxScore (Turtle and Flood 1995). lists sorted by bound; the prefix whose
+// bounds sum to at most the threshold is non-essential and only probed with
+// next_geq() for documents found through the essential lists.
+template <class t_index>
+size_t topk_query_maxscore(const t_index& index, const std::vector<uint64_t>& terms, size_t k,
+std::vector<doc_score>& result)
+{
+	using cursor_type = typename scored_cursor<t_index>::cursor_type;
+	auto cursors	  = open_cursors(index, terms);
+	std::sort(cursors.begin(), cursors.end(),
+	[](const scored_cursor<t_index>& a, const scored_cursor<t_index>& b) {
+		return a.max_score < b.max_score;
+	});
+	std::vector<double> bounds(cursors.size());
+	double				sum = 0;
+	for (size_t i = 0; i < cursors.size(); i++) {
+		sum += cursors[i].max_score;
+		bounds[i] = sum;
+	}
+	topk_queue topk(k);
+
+	size_t   first_essential = 0;
+	uint32_t cur			 = cursor_type::end_docid;
+	for (auto& c : cursors)
+		cur = std::min(cur, c.cursor.docid());
+	while (first_essential < cursors.size() && cur != cursor_type::end_docid) {
+		double score = 0;
+		for (size_t i = first_essential; i < cursors.size(); i++) {
+			if (cursors[i].cursor.docid() == cur) {
+				score += cursors[i].score(index);
+				cursors[i].cursor.next();
+			}
+		}
+		for (size_t i = first_essential; i-- > 0;) {
+			if (score + bounds[i] <= topk.threshold()) break;
+			cursors[i].cursor.next_geq(cur);
+			if (cursors[i].cursor.docid() == cur) score += cursors[i].score(index);
+		}
+		if (topk.insert(cur, score)) {
+			while (first_essential < cursors.size()
+				   && bounds[first_essential] <= topk.threshold()) {
+				first_essential++;
+			}
+		}
+		cur = cursor_type::end_docid;
+		for (size_t i = first_essential; i < cursors.size(); i++)
+			cur = std::min(cur, cursors[i].cursor.docid());
+	}
+	topk.finalize(result);
+	return result.size();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// okapi bm25. the per-term score upper bounds stored in the index are
+// computed with these parameters so queries have to use the same ones.
+struct bm25 {
+	static constexpr double k1 = 0.9;
+	static constexpr double b  = 0.4;
+
+	// always positive so terms occurring in most documents do not subtract
+	static double idf(uint64_t num_docs, uint64_t df)
+	{
+		return std::log(1.0 + (double(num_docs) - double(df) + 0.5) / (double(df) + 0.5));
+	}
+
+	static double tf(uint32_t f, uint32_t doc_len, double avg_doc_len)
+	{
+		double norm = k1 * (1.0 - b + b * double(doc_len) / avg_doc_len);
+		return (double(f) * (k1 + 1.0)) / (double(f) + norm);
+	}
+
+	static double score(double idf, uint32_t f, uint32_t doc_len, double avg_doc_len)
+	{
+		return idf * tf(f, doc_len, avg_doc_len);
+	}
+};
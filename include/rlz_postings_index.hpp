@@ -0,0 +1,204 @@
+#pragma once
+
+#include "utils.hpp"
+#include "collection.hpp"
+#include "bit_streams.hpp"
+#include "list_data.hpp"
+#include "list_dictionary.hpp"
+
+#include "rlz_store.hpp"
+
+#include <cstring>
+
+/*
+    serves the postings lists of an inverted index whose list files were
+    compressed with an rlz_store. a directory maps every list to the byte
+    range of the list file holding it, so fetching a list decodes only the
+    blocks covering that range and copies only the factors overlapping it.
+    the list bytes are then decoded with the list types the index was
+    written with.
+ */
+template <class t_rlz_store, class t_doc_list, class t_freq_list>
+class rlz_postings_index {
+public:
+    using size_type = uint64_t;
+    enum { block_size = t_rlz_store::block_size };
+    // list files are sdsl bit vectors: [size in bits:64][data words]
+    static const uint64_t header_bytes = 8;
+    // ranges start on a 128 bit boundary of the list file so the list
+    // codecs see the same alignment as in the uncompressed file
+    static const uint64_t align_bits = 128;
+    // zeroed bytes behind a range for codecs reading past the list end
+    static const uint64_t slack_bytes = 64;
+
+    // byte range [begin,end) of each list within a list file
+    struct byte_directory {
+        sdsl::int_vector<> m_begin;
+        sdsl::int_vector<> m_end;
+
+        size_type size_in_bytes() const
+        {
+            return sdsl::size_in_bytes(m_begin) + sdsl::size_in_bytes(m_end);
+        }
+    };
+
+private:
+    const t_rlz_store& m_docs;
+    const t_rlz_store& m_freqs;
+    meta_data m_meta_data;
+    byte_directory m_doc_dir;
+    byte_directory m_freq_dir;
+    std::unique_ptr<typename list_dictionary<t_doc_list>::state_type> m_doc_dict;
+    std::unique_ptr<typename list_dictionary<t_freq_list>::state_type> m_freq_dict;
+
+public:
+    std::string name;
+
+    static std::string type()
+    {
+        return "rlz_postings<" + t_doc_list::type() + "," + t_freq_list::type() + ">";
+    }
+
+    // the stores have to outlive the index
+    rlz_postings_index(const invidx_collection& col, const t_rlz_store& docs,
+        const t_rlz_store& freqs, std::string n)
+        : m_docs(docs)
+        , m_freqs(freqs)
+        , m_meta_data(col.m_meta_data)
+        , m_doc_dict(new typename list_dictionary<t_doc_list>::state_type())
+        , m_freq_dict(new typename list_dictionary<t_freq_list>::state_type())
+        , name(n)
+    {
+        LOG(INFO) << "[" << name << "] " << "build list directory";
+        std::vector<uint64_t> doc_offsets(num_lists());
+        std::vector<uint64_t> freq_offsets(num_lists());
+        for (size_t i = 0; i < num_lists(); i++) {
+            doc_offsets[i] = m_meta_data.m_list_data[i].doc_offset;
+            freq_offsets[i] = m_meta_data.m_list_data[i].freq_offset;
+        }
+        m_doc_dir = build_directory(m_docs, doc_offsets);
+        m_freq_dir = build_directory(m_freqs, freq_offsets);
+        LOG(INFO) << "[" << name << "] " << "directory size = " << size_in_bytes() << " bytes";
+
+        // lists sharing a dictionary find it in front of the first list
+        read_dictionary<t_doc_list>(m_docs, doc_offsets, *m_doc_dict);
+        read_dictionary<t_freq_list>(m_freqs, freq_offsets, *m_freq_dict);
+    }
+
+    size_type num_lists() const { return m_meta_data.m_num_lists; }
+
+    size_t list_len(size_type idx) const { return m_meta_data.m_list_data[idx].list_len; }
+
+    size_type size_in_bytes() const
+    {
+        return m_doc_dir.size_in_bytes() + m_freq_dir.size_in_bytes();
+    }
+
+    // decode only the doc ids of list idx
+    void decode_docs_into(size_type idx, list_data& ld) const
+    {
+        const auto& lm = m_meta_data.m_list_data[idx];
+
+        ld.list_len = lm.list_len;
+        ld.grow(lm.list_len);
+
+        auto& bv = fetch(m_docs, m_doc_dir, idx);
+        bit_istream<sdsl::bit_vector> docfs(bv);
+        docfs.seek(lm.doc_offset % align_bits);
+        list_dictionary<t_doc_list>::decode(*m_doc_dict, docfs, ld.doc_ids, lm.list_len, m_meta_data.m_num_docs);
+    }
+
+    // decode list idx into caller owned buffers. safe to call concurrently.
+    void decode_into(size_type idx, list_data& ld) const
+    {
+        const auto& lm = m_meta_data.m_list_data[idx];
+        decode_docs_into(idx, ld);
+
+        auto& bv = fetch(m_freqs, m_freq_dir, idx);
+        bit_istream<sdsl::bit_vector> freqfs(bv);
+        freqfs.seek(lm.freq_offset % align_bits);
+        list_dictionary<t_freq_list>::decode(*m_freq_dict, freqfs, ld.freqs, lm.list_len, lm.Ft);
+    }
+
+    // decode into the calling thread's scratch buffer. the reference stays
+    // valid until the same thread decodes the next list.
+    list_data& operator[](size_type idx) const
+    {
+        auto& ld = list_scratch::get();
+        decode_into(idx, ld);
+        return ld;
+    }
+
+private:
+    // copy bytes [begin,end) of the text of store into out
+    static void decode_bytes(const t_rlz_store& store, uint64_t begin, uint64_t end, uint8_t* out)
+    {
+        static thread_local block_factor_data bfd(block_size);
+        for (uint64_t b = begin / block_size; b * block_size < end; b++) {
+            uint64_t block_start = b * block_size;
+            uint64_t from = std::max(begin, block_start) - block_start;
+            uint64_t to = std::min(end, block_start + block_size) - block_start;
+            out += store.decode_block_range(b, from, to, out, bfd);
+        }
+    }
+
+    // the bytes of a range followed by zeroed slack. private to the index
+    // as the list codecs use utils::thread_scratch themselves.
+    static sdsl::bit_vector& fetch_range(const t_rlz_store& store, uint64_t begin, uint64_t end)
+    {
+        static thread_local sdsl::bit_vector bv;
+        uint64_t bytes = end - begin;
+        uint64_t needed_bits = ((bytes + slack_bytes + 7) / 8) * 64;
+        if (bv.size() < needed_bits) {
+            bv.resize(needed_bits);
+        }
+        uint8_t* data = (uint8_t*)bv.data();
+        decode_bytes(store, begin, end, data);
+        memset(data + bytes, 0, slack_bytes);
+        return bv;
+    }
+
+    static sdsl::bit_vector& fetch(const t_rlz_store& store, const byte_directory& dir, size_type idx)
+    {
+        return fetch_range(store, dir.m_begin[idx], dir.m_end[idx]);
+    }
+
+    static uint64_t stream_bits(const t_rlz_store& store)
+    {
+        uint64_t bits = 0;
+        decode_bytes(store, 0, header_bytes, (uint8_t*)&bits);
+        return bits;
+    }
+
+    // list i spans from the 128 bit word holding its first bit up to the
+    // byte holding the last bit before list i+1
+    static byte_directory build_directory(const t_rlz_store& store, const std::vector<uint64_t>& offsets)
+    {
+        byte_directory dir;
+        uint64_t total_bits = stream_bits(store);
+        if (header_bytes + (total_bits + 7) / 8 > store.size()) {
+            LOG(FATAL) << "list file size does not match the rlz store";
+            throw std::runtime_error("list file size does not match the rlz store.");
+        }
+        dir.m_begin = sdsl::int_vector<>(offsets.size(), 0);
+        dir.m_end = sdsl::int_vector<>(offsets.size(), 0);
+        for (size_t i = 0; i < offsets.size(); i++) {
+            uint64_t next = i + 1 < offsets.size() ? offsets[i + 1] : total_bits;
+            dir.m_begin[i] = header_bytes + (offsets[i] / align_bits) * (align_bits / 8);
+            dir.m_end[i] = header_bytes + (next + 7) / 8;
+        }
+        sdsl::util::bit_compress(dir.m_begin);
+        sdsl::util::bit_compress(dir.m_end);
+        return dir;
+    }
+
+    template <class t_list>
+    static void read_dictionary(const t_rlz_store& store, const std::vector<uint64_t>& offsets,
+        typename list_dictionary<t_list>::state_type& state)
+    {
+        if (offsets.empty() || offsets[0] == 0) return;
+        auto& bv = fetch_range(store, header_bytes, header_bytes + (offsets[0] + 7) / 8);
+        bit_istream<sdsl::bit_vector> fs(bv);
+        list_dictionary<t_list>::read(fs, state);
+    }
+};
@@ -15,12 +15,14 @@ using namespace std::chrono;
 
 template <class t_dictionary_creation_strategy,
     uint32_t t_factorization_block_size,
-    class t_factor_coder>
+    class t_factor_coder,
+    class t_dict_index = dict_index_sa,
+    class t_factor_parser = factor_parse_greedy>
 class rlz_store {
 public:
     using dictionary_creation_strategy = t_dictionary_creation_strategy;
     using factor_coder_type = t_factor_coder;
-    using factorization_strategy = factorizor<t_factorization_block_size,factor_coder_type>;
+    using factorization_strategy = factorizor<t_factorization_block_size,factor_coder_type,t_dict_index,t_factor_parser>;
     using block_map_type = block_map_uncompressed<true>;
     using size_type = uint64_t;
 private:
@@ -60,7 +62,11 @@ public:
         
         // (2) load the block map
         LOG(INFO) << "["<<name<<"] " << "\tload block map";
-        sdsl::load_from_file( m_blockmap, col.file_name(hash,block_map_uncompressed<true>::type()) );
+        auto block_map_file = col.file_name(hash,factorization_strategy::block_map_type());
+        if (!sdsl::load_from_file(m_blockmap,block_map_file)) {
+            LOG(FATAL) << "["<<name<<"] " << "block map " << block_map_file << " not found. rebuild the store.";
+            throw std::runtime_error("rlz block map not found.");
+        }
 
         // (3) load dictionary from disk
         LOG(INFO) << "["<<name<<"] " << "\tload dictionary";
@@ -143,6 +149,43 @@ public:
         return written_syms;
     }
 
+    // decode bytes [from,to) of block block_id into out. the factors of the
+    // block are entropy decoded but only the ones overlapping the range are
+    // copied. uses its own stream so concurrent calls are safe.
+    inline uint64_t decode_block_range(uint64_t block_id, uint64_t from, uint64_t to,
+        uint8_t* out, block_factor_data& bfd) const
+    {
+        bit_istream<sdsl::int_vector_mapper<1, std::ios_base::in> > factor_stream(m_factored_data);
+        auto num_factors = m_blockmap.block_factors(block_id);
+        factor_stream.seek(m_blockmap.block_offset(block_id));
+        m_factor_coder.decode_block(factor_stream, bfd, num_factors);
+
+        auto out_start = out;
+        size_t literals_used = 0;
+        size_t offsets_used = 0;
+        uint64_t pos = 0;
+        for (size_t i = 0; i < num_factors && pos < to; i++) {
+            const auto& factor_len = bfd.lengths[i];
+            auto lo = std::max(pos, from);
+            auto hi = std::min(pos + factor_len, to);
+            if (factor_len <= m_factor_coder.literal_threshold) {
+                if (lo < hi) {
+                    auto begin = bfd.literals.begin() + literals_used + (lo - pos);
+                    out = std::copy(begin, begin + (hi - lo), out);
+                }
+                literals_used += factor_len;
+            } else {
+                if (lo < hi) {
+                    auto begin = m_dict.begin() + bfd.offsets[offsets_used] + (lo - pos);
+                    out = std::copy(begin, begin + (hi - lo), out);
+                }
+                offsets_used++;
+            }
+            pos += factor_len;
+        }
+        return out - out_start;
+    }
+
     std::vector<uint8_t>
     block(const size_t block_id) const
     {
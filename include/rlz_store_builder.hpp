@@ -7,14 +7,18 @@
 
 template <class t_dictionary_creation_strategy,
     uint32_t t_factorization_block_size,
-    class t_factor_coder>
+    class t_factor_coder,
+    class t_dict_index,
+    class t_factor_parser>
 class rlz_store<t_dictionary_creation_strategy,
     t_factorization_block_size,
-    t_factor_coder>::builder {
+    t_factor_coder,
+    t_dict_index,
+    t_factor_parser>::builder {
 public:
     using dictionary_creation_strategy = t_dictionary_creation_strategy;
     using factor_encoder = t_factor_coder;
-    using factorization_strategy = factorizor<t_factorization_block_size, factor_encoder>;
+    using factorization_strategy = factorizor<t_factorization_block_size, factor_encoder, t_dict_index, t_factor_parser>;
     using block_map_type = block_map_uncompressed<true>;
     enum { block_size = t_factorization_block_size };
 
@@ -54,6 +58,16 @@ public:
         // (1) create factorized text using the dict
         auto hash = dict_hash xor input_hash;
         auto factor_file_name = col.file_name(hash,factorization_strategy::type());
+        if (!rebuild && !utils::file_exists(factor_file_name)) {
+            for (const auto& legacy_type : factorization_strategy::legacy_types()) {
+                auto legacy_file_name = col.file_name(hash,legacy_type);
+                if (utils::file_exists(legacy_file_name)) {
+                    LOG(FATAL) << "["<<name<<"] " << "factorized text " << legacy_file_name
+                               << " uses an old file format. rebuild the store (-f).";
+                    throw std::runtime_error("rlz store in an old file format.");
+                }
+            }
+        }
         if (rebuild || !utils::file_exists(factor_file_name)) {
             factorization_strategy::parallel_factorize(col,input_file,dict,hash,num_threads,name);
         }
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+
+#include <array>
+#include <atomic>
+
+// the storage indexes transform and compress their integer stream in frames
+// of a fixed number of integers. frames are compressed independently, one
+// after the other, so construction only ever holds one frame in memory and
+// a range of the stream can be recovered by decoding just the frames it
+// spans.
+struct storage_chunks {
+	// memory needed per integer of a frame: the integer itself, its
+	// transformed representation and room for the compressor output
+	static const uint64_t bytes_per_int		 = 16;
+	static const uint64_t default_mem_budget = 1ULL << 30;
+	// no cap: frames are as large as the budget allows, which gives the
+	// compressors the largest window. a cap keeps decoding short lists cheap.
+	static const uint64_t default_frame_size = 0;
+
+	static uint64_t frame_size(uint64_t mem_budget, uint64_t max_frame_size = default_frame_size)
+	{
+		uint64_t frame_size = std::max(mem_budget / bytes_per_int, uint64_t(1024));
+		if (max_frame_size != 0) frame_size = std::min(frame_size, max_frame_size);
+		return frame_size;
+	}
+};
+
+// where the frames of one compressed stream start and how large their
+// transformed representation is
+struct storage_frames {
+	using size_type = uint64_t;
+
+	uint64_t		   m_frame_size = 0;
+	sdsl::int_vector<> m_offsets;
+	sdsl::int_vector<> m_bytes;
+	// identifies the frames in the per-thread frame cache. assigned whenever
+	// frames are created or loaded, never serialized.
+	uint64_t m_id = next_id();
+
+	size_t size() const { return m_offsets.size(); }
+
+	static uint64_t next_id()
+	{
+		static std::atomic<uint64_t> id(0);
+		return ++id;
+	}
+
+	size_type serialize(std::ostream& out, sdsl::structure_tree_node* v = NULL, std::string name = "") const
+	{
+		auto child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+		size_type written_bytes = 0;
+		written_bytes += sdsl::serialize(m_frame_size, out, child, "frame_size");
+		written_bytes += m_offsets.serialize(out, child, "offsets");
+		written_bytes += m_bytes.serialize(out, child, "bytes");
+		sdsl::structure_tree::add_size(child, written_bytes);
+		return written_bytes;
+	}
+
+	void load(std::istream& in)
+	{
+		sdsl::read_member(m_frame_size, in);
+		m_offsets.load(in);
+		m_bytes.load(in);
+		m_id = next_id();
+	}
+};
+
+template <class t_transform, class t_compress>
+struct storage_chunk_writer {
+	storage_chunk_writer(sdsl::bit_vector& out, uint64_t frame_size)
+		: m_os(out), m_frame_size(frame_size)
+	{
+		m_frame.reserve(frame_size + 1024);
+	}
+
+	void push_back(uint32_t x)
+	{
+		m_frame.push_back(x);
+		if (m_frame.size() == m_frame_size) flush();
+	}
+
+	// compress the last partial frame and return the frame table
+	storage_frames finish()
+	{
+		if (!m_frame.empty()) flush();
+		m_os.flush();
+		storage_frames frames;
+		frames.m_frame_size = m_frame_size;
+		frames.m_offsets.resize(m_offsets.size());
+		frames.m_bytes.resize(m_bytes.size());
+		for (size_t i = 0; i < m_offsets.size(); i++) {
+			frames.m_offsets[i] = m_offsets[i];
+			frames.m_bytes[i]   = m_bytes[i];
+		}
+		sdsl::util::bit_compress(frames.m_offsets);
+		sdsl::util::bit_compress(frames.m_bytes);
+		return frames;
+	}
+
+private:
+	void flush()
+	{
+		{
+			bit_ostream<sdsl::bit_vector> tfs(m_transformed);
+			t_transform					  coder;
+			coder.encode(tfs, m_frame.data(), m_frame.size());
+		}
+		size_t	 num_bytes = m_transformed.size() / 8;
+		t_compress coder;
+		m_offsets.push_back(m_os.tellp());
+		coder.encode(m_os, (const uint8_t*)m_transformed.data(), num_bytes);
+		m_bytes.push_back(num_bytes);
+		m_frame.clear();
+	}
+
+	bit_ostream<sdsl::bit_vector> m_os;
+	uint64_t					  m_frame_size;
+	std::vector<uint32_t>		  m_frame;
+	sdsl::bit_vector			  m_transformed;
+	std::vector<uint64_t>		  m_offsets;
+	std::vector<uint64_t>		  m_bytes;
+};
+
+// random access to the integers written by storage_chunk_writer. the last
+// few decoded frames are kept per thread so walking the lists in order
+// decodes every frame once, even when doc and freq streams alternate.
+template <class t_transform, class t_compress>
+struct storage_chunk_reader {
+	storage_chunk_reader(const sdsl::bit_vector& data, const storage_frames& frames, uint64_t num_ints)
+		: m_data(data), m_frames(frames), m_num_ints(num_ints)
+	{
+	}
+
+	// copy the integers [begin, begin+n) of the stream to out
+	void decode(uint64_t begin, size_t n, uint32_t* out) const
+	{
+		while (n) {
+			size_t		f	  = begin / m_frames.m_frame_size;
+			size_t		offset = begin % m_frames.m_frame_size;
+			const auto& frame  = load(f);
+			size_t		len	= std::min(n, frame.len - offset);
+			std::copy(frame.ints.begin() + offset, frame.ints.begin() + offset + len, out);
+			out += len;
+			begin += len;
+			n -= len;
+		}
+	}
+
+private:
+	struct frame_cache {
+		uint64_t			  id	= 0;
+		uint64_t			  used  = 0;
+		size_t				  frame = 0;
+		size_t				  len   = 0;
+		std::vector<uint32_t> ints;
+		sdsl::bit_vector	  transformed;
+	};
+
+	const frame_cache& load(size_t f) const
+	{
+		static thread_local std::array<frame_cache, 4> slots;
+		static thread_local uint64_t				   clock = 0;
+		frame_cache*								   lru   = &slots[0];
+		for (auto& slot : slots) {
+			if (slot.id == m_frames.m_id && slot.frame == f) {
+				slot.used = ++clock;
+				return slot;
+			}
+			if (slot.used < lru->used) lru = &slot;
+		}
+		auto& cache		   = *lru;
+		cache.used		   = ++clock;
+		uint64_t num_bytes = m_frames.m_bytes[f];
+		cache.id		   = m_frames.m_id;
+		cache.frame		   = f;
+		cache.len		   = std::min(m_frames.m_frame_size, m_num_ints - f * m_frames.m_frame_size);
+		if (cache.transformed.size() < 1024 * 8 + num_bytes * 8) {
+			cache.transformed.resize(1024 * 8 + num_bytes * 8);
+		}
+		if (cache.ints.size() < cache.len + 1024) cache.ints.resize(cache.len + 1024);
+
+		bit_istream<sdsl::bit_vector> is(m_data);
+		is.seek(m_frames.m_offsets[f]);
+		t_compress decoder;
+		decoder.decode(is, (uint8_t*)cache.transformed.data(), num_bytes);
+		bit_istream<sdsl::bit_vector> tfs(cache.transformed);
+		t_transform					  coder;
+		coder.decode(tfs, cache.ints.data(), cache.len);
+		return cache;
+	}
+
+	const sdsl::bit_vector& m_data;
+	const storage_frames&   m_frames;
+	uint64_t				m_num_ints;
+};
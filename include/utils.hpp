@@ -13,6 +13,7 @@
 #include <chrono>
 
 #include <zlib.h>
+#include <immintrin.h>
 #include <dirent.h>
 
 #include "easylogging++.h"
@@ -303,45 +304,108 @@ inline uint32_t read_uint32(std::ifstream& ifs) {
     return n;
 }
 
-inline void dgap_list(std::vector<uint32_t>& buf,size_t n) {
-    size_t prev = buf[0];
-    for(size_t i=1;i<n;i++) {
-        uint32_t cur = buf[i];
-        uint32_t gap = cur - prev;
-        prev = cur;
-        buf[i] = gap;
+// inclusive prefix sum of in[0,n) into out starting from base. returns the
+// last sum so block decoders can carry it into the next block. in and out
+// may be the same array.
+inline uint32_t prefix_sum(const uint32_t* in,uint32_t* out,size_t n,uint32_t base = 0) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i carry = _mm256_set1_epi32(base);
+    for(;i+8<=n;i+=8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(in+i));
+        x = _mm256_add_epi32(x,_mm256_slli_si256(x,4));
+        x = _mm256_add_epi32(x,_mm256_slli_si256(x,8));
+        // the high lane also needs the sum of the low lane
+        __m256i lo = _mm256_permute2x128_si256(x,x,0x08);
+        x = _mm256_add_epi32(x,_mm256_shuffle_epi32(lo,0xFF));
+        x = _mm256_add_epi32(x,carry);
+        _mm256_storeu_si256((__m256i*)(out+i),x);
+        carry = _mm256_permutevar8x32_epi32(x,_mm256_set1_epi32(7));
+    }
+    base = _mm_cvtsi128_si32(_mm256_castsi256_si128(carry));
+#elif defined(__SSE2__)
+    __m128i carry = _mm_set1_epi32(base);
+    for(;i+4<=n;i+=4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(in+i));
+        x = _mm_add_epi32(x,_mm_slli_si128(x,4));
+        x = _mm_add_epi32(x,_mm_slli_si128(x,8));
+        x = _mm_add_epi32(x,carry);
+        _mm_storeu_si128((__m128i*)(out+i),x);
+        carry = _mm_shuffle_epi32(x,0xFF);
+    }
+    base = _mm_cvtsi128_si32(carry);
+#endif
+    for(;i<n;i++) {
+        base += in[i];
+        out[i] = base;
     }
+    return base;
 }
 
-inline void undo_dgap_list(std::vector<uint32_t>& buf,size_t n) {
-    size_t prev = buf[0];
-    for(size_t i=1;i<n;i++) {
-        uint32_t cur = buf[i];
-        buf[i] = cur + prev;
-        prev = buf[i];
+inline uint32_t prefix_sum(uint32_t* data,size_t n,uint32_t base = 0) {
+    return prefix_sum(data,data,n,base);
+}
+
+// inverse of prefix_sum: data[i] -= data[i-1] with data[-1] = base
+inline void adjacent_difference(uint32_t* data,size_t n,uint32_t base = 0) {
+    size_t i = 0;
+#if defined(__SSSE3__)
+    __m128i prev = _mm_set1_epi32(base);
+    for(;i+4<=n;i+=4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(data+i));
+        __m128i shifted = _mm_alignr_epi8(x,prev,12);
+        _mm_storeu_si128((__m128i*)(data+i),_mm_sub_epi32(x,shifted));
+        prev = x;
+    }
+    base = _mm_cvtsi128_si32(_mm_srli_si128(prev,12));
+#endif
+    for(;i<n;i++) {
+        uint32_t cur = data[i];
+        data[i] = cur - base;
+        base = cur;
     }
 }
 
+inline void dgap_list(std::vector<uint32_t>& buf,size_t n) {
+    adjacent_difference(buf.data(),n);
+}
+
+inline void undo_dgap_list(std::vector<uint32_t>& buf,size_t n) {
+    prefix_sum(buf.data(),n);
+}
 
 inline void prefixsum_list(std::vector<uint32_t>& buf,size_t n) {
-    size_t prefixsum = buf[0];
-    for(size_t i=1;i<n;i++) {
-        uint32_t cur = buf[i];
-        prefixsum += cur;
-        buf[i] = prefixsum;
-    }
+    prefix_sum(buf.data(),n);
 }
 
 inline void undo_prefixsum_list(std::vector<uint32_t>& buf,size_t n) {
-    size_t prefixsum = buf[0];
-    for(size_t i=1;i<n;i++) {
-        uint32_t cur = buf[i];
-        buf[i] = cur - prefixsum;
-        prefixsum = cur;
+    adjacent_difference(buf.data(),n);
+}
+
+// scratch space of the calling thread for decoders that undo one encoding
+// into memory before undoing the next. it grows to the largest request of
+// the thread and is reused afterwards, so it is bounded by the largest list
+// and never shared between threads.
+inline sdsl::bit_vector& thread_scratch(size_t num_u32) {
+    static thread_local sdsl::bit_vector scratch;
+    // decoders may read a few words past the data
+    size_t bits = (num_u32 + 64) * 32ULL;
+    if (scratch.size() < bits) {
+        scratch.resize(bits);
     }
+    return scratch;
 }
 
 
+// append zero bytes behind the serialized data. mmapped readers only see the
+// file, so this gives decoders that read whole words past the end some slack.
+void pad_file(std::string file, size_t bytes)
+{
+    std::ofstream ofs(file, std::ios::binary | std::ios::app);
+    std::vector<char> zeros(bytes, 0);
+    ofs.write(zeros.data(), bytes);
+}
+
 std::streamoff file_size(std::string file) {
     std::ifstream input(file, std::ios::binary);
     std::streamoff fs = 0;
@@ -13,14 +13,16 @@ INITIALIZE_EASYLOGGINGPP
 typedef struct cmdargs {
 	std::string collection_dir;
 	std::string input_prefix;
+	bool		mapped;
 } cmdargs_t;
 
 void print_usage(const char* program)
 {
-	fprintf(stdout, "%s -c <collection directory> -i <input prefix>\n", program);
+	fprintf(stdout, "%s -c <collection directory> -i <input prefix> [-m]\n", program);
 	fprintf(stdout, "where\n");
 	fprintf(stdout, "  -c <collection directory>  : the directory the collection is stored.\n");
 	fprintf(stdout, "  -i <input prefix>          : the d2si input prefix.\n");
+	fprintf(stdout, "  -m                         : mmap the index instead of loading it.\n");
 };
 
 cmdargs_t parse_args(int argc, const char* argv[])
@@ -29,7 +31,8 @@ cmdargs_t parse_args(int argc, const char* argv[])
 	int		  op;
 	args.collection_dir = "";
 	args.input_prefix   = "";
-	while ((op = getopt(argc, (char* const*)argv, "c:i:")) != -1) {
+	args.mapped			= false;
+	while ((op = getopt(argc, (char* const*)argv, "c:i:m")) != -1) {
 		switch (op) {
 			case 'c':
 				args.collection_dir = optarg;
@@ -37,6 +40,9 @@ cmdargs_t parse_args(int argc, const char* argv[])
 			case 'i':
 				args.input_prefix = optarg;
 				break;
+			case 'm':
+				args.mapped = true;
+				break;
 		}
 	}
 	if (args.collection_dir == "" || args.input_prefix == "") {
@@ -61,11 +67,17 @@ bool index_exists(std::string col_dir)
 	if (!utils::file_exists(meta_file)) {
 		return false;
 	}
+	if (!utils::file_exists(col_dir + "/" + DOCLENS_NAME)) {
+		return false;
+	}
+	if (!utils::file_exists(col_dir + "/" + BLOCKMAX_NAME)) {
+		return false;
+	}
 	return true;
 }
 
 template <class t_doc_list, class t_freq_list>
-void bench_invidx(std::string input_prefix, std::string collection_dir)
+void bench_invidx(std::string input_prefix, std::string collection_dir, bool mapped)
 {
 	using timer		  = std::chrono::high_resolution_clock;
 	using invidx_type = inverted_index<t_doc_list, t_freq_list>;
@@ -79,7 +91,11 @@ void bench_invidx(std::string input_prefix, std::string collection_dir)
 		verify = true;
 	}
 	LOG(INFO) << "load inverted index (" << invidx_type::type() << ")";
-	invidx_loaded.read(collection_dir);
+	if (mapped) {
+		invidx_loaded.read_mapped(collection_dir);
+	} else {
+		invidx_loaded.read(collection_dir);
+	}
 	invidx_loaded.stats();
 	if (verify) {
 		LOG(INFO) << "verify loaded index against input data";
@@ -116,11 +132,12 @@ void bench_invidx(std::string input_prefix, std::string collection_dir)
 	LOG(INFO) << "Perform 3 runs and take fastest";
 	std::vector<std::chrono::nanoseconds> timings;
 	size_t								  checksum = 0;
+	list_data							  list(invidx_loaded.num_docs());
 	for (size_t j = 0; j < 3; j++) {
 		for (size_t i = 0; i < list_ids.size(); i++) {
-			auto		start = timer::now();
-			const auto& list  = invidx_loaded[list_ids[i]];
-			auto		stop  = timer::now();
+			auto start = timer::now();
+			invidx_loaded.decode_into(list_ids[i], list);
+			auto stop = timer::now();
 			checksum += list.list_len;
 
 			if (timings.size() <= i) {
@@ -151,61 +168,151 @@ int main(int argc, const char* argv[])
 		using doc_list_type  = list_qmx<true>;
 		using freq_list_type = list_qmx<false>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
 	}
 	{
 		using doc_list_type  = list_vbyte<true>;
 		using freq_list_type = list_vbyte<false>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
 	}
 	{
 		using doc_list_type  = list_simple16<true>;
 		using freq_list_type = list_simple16<false>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
 	}
 	{
 		using doc_list_type  = list_op4<128, true>;
 		using freq_list_type = list_op4<128, false>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_simdbp128<true>;
+		using freq_list_type = list_simdbp128<false>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_simdfastpfor<true>;
+		using freq_list_type = list_simdfastpfor<false>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_streamvbyte<true>;
+		using freq_list_type = list_streamvbyte<false>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_maskedvbyte<true>;
+		using freq_list_type = list_maskedvbyte<false>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_varintg8iu<true>;
+		using freq_list_type = list_varintg8iu<false>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
 	}
 	{
 		using doc_list_type  = list_ef<false>;
 		using freq_list_type = list_ef<true>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_pef<false>;
+		using freq_list_type = list_pef<true>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
 	}
 	{
 		using doc_list_type  = list_interp<false>;
 		using freq_list_type = list_interp<true>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_adaptive<true, 0>;
+		using freq_list_type = list_adaptive<false, 0>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_adaptive<true, 16>;
+		using freq_list_type = list_adaptive<false, 16>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
 	}
 	{
 		using doc_list_type  = list_u32<true>;
 		using freq_list_type = list_u32<false>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
 	}
 	{
 		using doc_list_type  = list_vbyte_lz<true, 128, coder::zstd<9>>;
 		using freq_list_type = list_vbyte_lz<false, 128, coder::zstd<9>>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
 	}
 	{
 		using doc_list_type  = list_vbyte_lz<true, 128, coder::lzma<6>>;
 		using freq_list_type = list_vbyte_lz<false, 128, coder::lzma<6>>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_vbyte_zdict<true, 16, 9>;
+		using freq_list_type = list_vbyte_zdict<false, 16, 9>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_rlz<true, 128>;
+		using freq_list_type = list_rlz<false, 128>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_rans<true, 128>;
+		using freq_list_type = list_rans<false, 128>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
 	}
 	{
 		using doc_list_type  = list_u32_lz<true, 128, coder::zstd<9>>;
 		using freq_list_type = list_u32_lz<false, 128, coder::zstd<9>>;
 		bench_invidx<doc_list_type, freq_list_type>(
-		args.input_prefix, args.collection_dir + "-" + doc_list_type::name());
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_skip<list_op4<128, true>>;
+		using freq_list_type = list_skip_freqs<list_op4<128, false>>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name() + "-" + freq_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_skip<list_qmx<true>>;
+		using freq_list_type = list_skip_freqs<list_qmx<false>>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name() + "-" + freq_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_skip<list_interp_block<128, false>>;
+		using freq_list_type = list_skip_freqs<list_interp_block<128, true>>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name() + "-" + freq_list_type::name(), args.mapped);
+	}
+	{
+		using doc_list_type  = list_skip<list_ef<false>>;
+		using freq_list_type = list_skip_freqs<list_ef<true>>;
+		bench_invidx<doc_list_type, freq_list_type>(
+		args.input_prefix, args.collection_dir + "-" + doc_list_type::name() + "-" + freq_list_type::name(), args.mapped);
 	}
 	return 0;
 }
@@ -0,0 +1,281 @@
+#include "logging.hpp"
+INITIALIZE_EASYLOGGINGPP
+
+#include "collection.hpp"
+#include "sdsl/int_vector_mapper.hpp"
+#include "bit_coders.hpp"
+#include "bit_streams.hpp"
+
+#include "inverted_index.hpp"
+#include "query_and.hpp"
+#include "query_topk.hpp"
+
+#include <chrono>
+#include <sstream>
+
+typedef struct cmdargs {
+	std::string collection_dir;
+	std::string input_prefix;
+	std::string query_file;
+	bool		mapped;
+} cmdargs_t;
+
+void print_usage(const char* program)
+{
+	fprintf(stdout, "%s -c <collection directory> -i <input prefix> [-q <query file>] [-m]\n",
+	program);
+	fprintf(stdout, "where\n");
+	fprintf(stdout, "  -c <collection directory>  : the directory the collection is stored.\n");
+	fprintf(stdout, "  -i <input prefix>          : the d2si input prefix.\n");
+	fprintf(stdout, "  -q <query file>            : one query of list ids per line. random if missing.\n");
+	fprintf(stdout, "  -m                         : mmap the index instead of loading it.\n");
+};
+
+cmdargs_t parse_args(int argc, const char* argv[])
+{
+	cmdargs_t args;
+	int		  op;
+	args.collection_dir = "";
+	args.input_prefix   = "";
+	args.query_file		= "";
+	args.mapped			= false;
+	while ((op = getopt(argc, (char* const*)argv, "c:i:q:m")) != -1) {
+		switch (op) {
+			case 'c':
+				args.collection_dir = optarg;
+				break;
+			case 'i':
+				args.input_prefix = optarg;
+				break;
+			case 'q':
+				args.query_file = optarg;
+				break;
+			case 'm':
+				args.mapped = true;
+				break;
+		}
+	}
+	if (args.collection_dir == "" || args.input_prefix == "") {
+		std::cerr << "Missing command line parameters.\n";
+		print_usage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	return args;
+}
+
+bool index_exists(std::string col_dir)
+{
+	auto docs_file  = col_dir + "/" + DOCS_NAME;
+	auto freqs_file = col_dir + "/" + FREQS_NAME;
+	auto meta_file  = col_dir + "/" + META_NAME;
+	return utils::file_exists(docs_file) && utils::file_exists(freqs_file)
+		   && utils::file_exists(meta_file) && utils::file_exists(col_dir + "/" + DOCLENS_NAME)
+		   && utils::file_exists(col_dir + "/" + BLOCKMAX_NAME);
+}
+
+using query_type = std::vector<uint64_t>;
+
+std::vector<query_type> read_queries(std::string query_file)
+{
+	std::vector<query_type> queries;
+	std::ifstream			in(query_file);
+	std::string				line;
+	while (std::getline(in, line)) {
+		std::istringstream ls(line);
+		query_type		   q;
+		uint64_t		   id;
+		while (ls >> id)
+			q.push_back(id);
+		if (!q.empty()) queries.push_back(q);
+	}
+	return queries;
+}
+
+// 2-4 terms drawn from the lists long enough to be interesting
+template <class t_index>
+std::vector<query_type> random_queries(const t_index& index, size_t num_queries)
+{
+	std::mt19937		  gen(4711);
+	std::vector<uint64_t> candidates;
+	for (size_t i = 0; i < index.num_lists(); i++) {
+		if (index.list_len(i) > 128) candidates.push_back(i);
+	}
+	if (candidates.empty()) {
+		LOG(ERROR) << "no lists longer than 128 postings to draw query terms from";
+		return {};
+	}
+	std::uniform_int_distribution<size_t> term_dis(0, candidates.size() - 1);
+	std::uniform_int_distribution<size_t> len_dis(2, 4);
+	std::vector<query_type>				  queries(num_queries);
+	for (auto& q : queries) {
+		size_t len = len_dis(gen);
+		for (size_t i = 0; i < len; i++)
+			q.push_back(candidates[term_dis(gen)]);
+		std::sort(q.begin(), q.end());
+		q.erase(std::unique(q.begin(), q.end()), q.end());
+	}
+	return queries;
+}
+
+template <class t_result, class t_index, class t_query_fn>
+void time_queries(const t_index& index, const std::vector<query_type>& queries,
+std::string strategy, t_query_fn query_fn)
+{
+	using timer = std::chrono::high_resolution_clock;
+	std::vector<std::chrono::nanoseconds> timings(queries.size(), std::chrono::nanoseconds::max());
+	t_result							  result;
+	size_t								  checksum = 0;
+	for (size_t j = 0; j < 3; j++) {
+		checksum = 0;
+		for (size_t i = 0; i < queries.size(); i++) {
+			auto start = timer::now();
+			query_fn(index, queries[i], result);
+			auto stop = timer::now();
+			checksum += result.size();
+			timings[i] = std::min(timings[i], std::chrono::nanoseconds(stop - start));
+		}
+	}
+	std::chrono::nanoseconds total(0);
+	for (auto& t : timings)
+		total += t;
+	LOG(INFO) << t_index::type() << ";" << strategy << ";" << queries.size() << ";" << checksum
+			  << ";" << (total.count() / std::max(queries.size(), size_t(1)));
+}
+
+template <class t_doc_list, class t_freq_list>
+void bench_query(cmdargs_t& args, std::string collection_dir)
+{
+	using invidx_type = inverted_index<t_doc_list, t_freq_list>;
+	if (!index_exists(collection_dir)) {
+		LOG(INFO) << "building inverted index (" << invidx_type::type() << ")";
+		invidx_type invidx(args.input_prefix);
+		invidx.write(collection_dir);
+	}
+	invidx_type index;
+	if (args.mapped) {
+		index.read_mapped(collection_dir);
+	} else {
+		index.read(collection_dir);
+	}
+
+	std::vector<query_type> queries;
+	if (args.query_file != "") {
+		queries = read_queries(args.query_file);
+	} else {
+		queries = random_queries(index, 1000);
+	}
+
+	using and_result = std::vector<uint32_t>;
+	time_queries<and_result>(index, queries, "svs-merge", and_query_svs<intersect::merge, invidx_type>);
+	time_queries<and_result>(
+	index, queries, "svs-galloping", and_query_svs<intersect::galloping, invidx_type>);
+	time_queries<and_result>(
+	index, queries, "svs-sse", and_query_svs<intersect::simd_sse, invidx_type>);
+	if (intersect::simd_avx2::supported()) {
+		time_queries<and_result>(
+		index, queries, "svs-avx2", and_query_svs<intersect::simd_avx2, invidx_type>);
+	}
+	time_queries<and_result>(index, queries, "svs-adaptive-sse",
+	and_query_svs<intersect::adaptive<intersect::simd_sse>, invidx_type>);
+	time_queries<and_result>(index, queries, "cursor", and_query_cursor<invidx_type>);
+
+	// ranked OR, the pruning strategies have to agree with exhaustive scoring
+	const size_t k = 10;
+	using topk_fn =
+	size_t (*)(const invidx_type&, const query_type&, size_t, std::vector<doc_score>&);
+	std::vector<std::pair<std::string, topk_fn>> strategies = {
+		{"top10-or", topk_query_or<invidx_type>},
+		{"top10-wand", topk_query_wand<invidx_type>},
+		{"top10-bmw", topk_query_bmw<invidx_type>},
+		{"top10-maxscore", topk_query_maxscore<invidx_type>}};
+	for (auto& s : strategies) {
+		size_t				   errors = 0;
+		std::vector<doc_score> expected, result;
+		for (const auto& q : queries) {
+			topk_query_or(index, q, k, expected);
+			s.second(index, q, k, result);
+			if (result.size() != expected.size()) {
+				errors++;
+				continue;
+			}
+			for (size_t i = 0; i < result.size(); i++) {
+				if (std::abs(result[i].score - expected[i].score) > 1e-6) {
+					errors++;
+					break;
+				}
+			}
+		}
+		if (errors != 0) {
+			LOG(ERROR) << s.first << " differs from exhaustive for " << errors << " queries";
+		}
+		auto topk_query = s.second;
+		time_queries<std::vector<doc_score>>(index, queries, s.first,
+		[topk_query, k](const invidx_type& idx, const query_type& q, std::vector<doc_score>& r) {
+			topk_query(idx, q, k, r);
+		});
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	setup_logger(argc, argv);
+
+	cmdargs_t args = parse_args(argc, argv);
+
+	LOG(INFO) << "index;strategy;queries;results;mean_time_ns";
+	{
+		using doc_list_type  = list_qmx<true>;
+		using freq_list_type = list_qmx<false>;
+		bench_query<doc_list_type, freq_list_type>(
+		args, args.collection_dir + "-" + doc_list_type::name());
+	}
+	{
+		using doc_list_type  = list_op4<128, true>;
+		using freq_list_type = list_op4<128, false>;
+		bench_query<doc_list_type, freq_list_type>(
+		args, args.collection_dir + "-" + doc_list_type::name());
+	}
+	{
+		using doc_list_type  = list_ef<false>;
+		using freq_list_type = list_ef<true>;
+		bench_query<doc_list_type, freq_list_type>(
+		args, args.collection_dir + "-" + doc_list_type::name());
+	}
+	{
+		using doc_list_type  = list_pef<false>;
+		using freq_list_type = list_pef<true>;
+		bench_query<doc_list_type, freq_list_type>(
+		args, args.collection_dir + "-" + doc_list_type::name());
+	}
+	{
+		using doc_list_type  = list_simple16<true>;
+		using freq_list_type = list_simple16<false>;
+		bench_query<doc_list_type, freq_list_type>(
+		args, args.collection_dir + "-" + doc_list_type::name());
+	}
+	{
+		using doc_list_type  = list_skip<list_op4<128, true>>;
+		using freq_list_type = list_skip_freqs<list_op4<128, false>>;
+		bench_query<doc_list_type, freq_list_type>(
+		args, args.collection_dir + "-" + doc_list_type::name() + "-" + freq_list_type::name());
+	}
+	{
+		using doc_list_type  = list_skip<list_qmx<true>>;
+		using freq_list_type = list_skip_freqs<list_qmx<false>>;
+		bench_query<doc_list_type, freq_list_type>(
+		args, args.collection_dir + "-" + doc_list_type::name() + "-" + freq_list_type::name());
+	}
+	{
+		using doc_list_type  = list_skip<list_interp_block<128, false>>;
+		using freq_list_type = list_skip_freqs<list_interp_block<128, true>>;
+		bench_query<doc_list_type, freq_list_type>(
+		args, args.collection_dir + "-" + doc_list_type::name() + "-" + freq_list_type::name());
+	}
+	{
+		using doc_list_type  = list_skip<list_ef<false>>;
+		using freq_list_type = list_skip_freqs<list_ef<true>>;
+		bench_query<doc_list_type, freq_list_type>(
+		args, args.collection_dir + "-" + doc_list_type::name() + "-" + freq_list_type::name());
+	}
+	return 0;
+}
@@ -13,14 +13,19 @@ INITIALIZE_EASYLOGGINGPP
 typedef struct cmdargs {
   std::string col_dir;
   std::string input_prefix;
+  uint64_t mem_budget;
 } cmdargs_t;
 
 void print_usage(const char *program) {
-  fprintf(stdout, "%s -c <collection directory> -i <input prefix>\n", program);
+  fprintf(stdout,
+          "%s -c <collection directory> -i <input prefix> [-m <mem budget>]\n",
+          program);
   fprintf(stdout, "where\n");
   fprintf(stdout, "  -c <collection directory>  : the directory the collection "
                   "is stored.\n");
   fprintf(stdout, "  -i <input prefix>          : the d2si input prefix.\n");
+  fprintf(stdout, "  -m <mem budget>            : MiB used for transforming and "
+                  "compressing chunks (default 1024).\n");
 };
 
 cmdargs_t parse_args(int argc, const char *argv[]) {
@@ -28,7 +33,8 @@ cmdargs_t parse_args(int argc, const char *argv[]) {
   int op;
   args.col_dir = "";
   args.input_prefix = "";
-  while ((op = getopt(argc, (char *const *)argv, "c:i:")) != -1) {
+  args.mem_budget = storage_chunks::default_mem_budget;
+  while ((op = getopt(argc, (char *const *)argv, "c:i:m:")) != -1) {
     switch (op) {
     case 'c':
       args.col_dir = optarg;
@@ -36,6 +42,9 @@ cmdargs_t parse_args(int argc, const char *argv[]) {
     case 'i':
       args.input_prefix = optarg;
       break;
+    case 'm':
+      args.mem_budget = std::stoull(optarg) * 1024 * 1024;
+      break;
     }
   }
   if (args.col_dir == "" || args.input_prefix == "") {
@@ -63,13 +72,14 @@ bool index_exists(std::string col_dir) {
 }
 
 template <class t_transform, class t_compress>
-void build_and_verify(std::string input_prefix, std::string collection_dir) {
+void build_and_verify(std::string input_prefix, std::string collection_dir,
+                      uint64_t mem_budget) {
   using idx_type = storage_index<t_transform, t_compress>;
   idx_type idx_loaded;
   bool verify = false;
   if (!index_exists(collection_dir)) {
     LOG(INFO) << "building storage index (" << idx_type::type() << ")";
-    idx_type idx(input_prefix);
+    idx_type idx(input_prefix, mem_budget);
     LOG(INFO) << "write storage index";
     idx.write(collection_dir);
     verify = true;
@@ -101,13 +111,14 @@ bool interleaved_index_exists(std::string col_dir) {
 
 template <class t_transform, class t_compress>
 void interleaved_build_and_verify(std::string input_prefix,
-                                  std::string collection_dir) {
+                                  std::string collection_dir,
+                                  uint64_t mem_budget) {
   using idx_type = interleaved_storage_index<t_transform, t_compress>;
   idx_type idx_loaded;
   bool verify = false;
   if (!interleaved_index_exists(collection_dir)) {
     LOG(INFO) << "building storage index (" << idx_type::type() << ")";
-    idx_type idx(input_prefix);
+    idx_type idx(input_prefix, mem_budget);
     LOG(INFO) << "write storage index";
     idx.write(collection_dir);
     verify = true;
@@ -135,21 +146,24 @@ int main(int argc, const char *argv[]) {
     using compress_t = coder::zstd<9>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
   {
     using trans_t = coder::vbyte_fastpfor;
     using compress_t = coder::zstd<9>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
   {
     using trans_t = coder::aligned_fixed<uint32_t>;
     using compress_t = coder::zstd<9>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
 
   {
@@ -157,21 +171,24 @@ int main(int argc, const char *argv[]) {
     using compress_t = coder::bzip2<9>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
   {
     using trans_t = coder::aligned_fixed<uint32_t>;
     using compress_t = coder::bzip2<9>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
   {
     using trans_t = coder::simple16;
     using compress_t = coder::bzip2<9>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
 
   {
@@ -179,21 +196,24 @@ int main(int argc, const char *argv[]) {
     using compress_t = coder::lzma<6>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
   {
     using trans_t = coder::aligned_fixed<uint32_t>;
     using compress_t = coder::lzma<6>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
   {
     using trans_t = coder::simple16;
     using compress_t = coder::lzma<6>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
 
   {
@@ -201,21 +221,24 @@ int main(int argc, const char *argv[]) {
     using compress_t = coder::aligned_fixed<uint8_t>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
   {
     using trans_t = coder::aligned_fixed<uint32_t>;
     using compress_t = coder::aligned_fixed<uint8_t>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
   {
     using trans_t = coder::simple16;
     using compress_t = coder::aligned_fixed<uint8_t>;
     std::string col_dir =
         args.col_dir + "-store-" + trans_t::type() + "-" + compress_t::type();
-    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir);
+    build_and_verify<trans_t, compress_t>(args.input_prefix, col_dir,
+                                          args.mem_budget);
   }
 
   {
@@ -223,24 +246,24 @@ int main(int argc, const char *argv[]) {
     using compress_t = coder::zstd<9>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
   {
     using trans_t = coder::aligned_fixed<uint32_t>;
     using compress_t = coder::zstd<9>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
   {
     using trans_t = coder::simple16;
     using compress_t = coder::zstd<9>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
 
   {
@@ -248,24 +271,24 @@ int main(int argc, const char *argv[]) {
     using compress_t = coder::bzip2<9>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
   {
     using trans_t = coder::aligned_fixed<uint32_t>;
     using compress_t = coder::bzip2<9>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
   {
     using trans_t = coder::simple16;
     using compress_t = coder::bzip2<9>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
 
   {
@@ -273,24 +296,24 @@ int main(int argc, const char *argv[]) {
     using compress_t = coder::lzma<6>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
   {
     using trans_t = coder::aligned_fixed<uint32_t>;
     using compress_t = coder::lzma<6>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
   {
     using trans_t = coder::simple16;
     using compress_t = coder::lzma<6>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
 
   {
@@ -298,24 +321,24 @@ int main(int argc, const char *argv[]) {
     using compress_t = coder::aligned_fixed<uint8_t>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
   {
     using trans_t = coder::aligned_fixed<uint32_t>;
     using compress_t = coder::aligned_fixed<uint8_t>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
   {
     using trans_t = coder::simple16;
     using compress_t = coder::aligned_fixed<uint8_t>;
     std::string col_dir =
         args.col_dir + "-istore-" + trans_t::type() + "-" + compress_t::type();
-    interleaved_build_and_verify<trans_t, compress_t>(args.input_prefix,
-                                                      col_dir);
+    interleaved_build_and_verify<trans_t, compress_t>(
+        args.input_prefix, col_dir, args.mem_budget);
   }
 
   return 0;
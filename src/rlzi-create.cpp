@@ -6,6 +6,8 @@
 #include "lz_utils.hpp"
 
 #include "indexes.hpp"
+#include "inverted_index.hpp"
+#include "rlz_postings_index.hpp"
 
 #include "logging.hpp"
 INITIALIZE_EASYLOGGINGPP
@@ -37,6 +39,47 @@ void compress(utils::cmdargs& args,invidx_collection& col,std::string name) {
     LOG(INFO) << name << ": " << block_size << " DBPI = " << DBPI << " FBPI = " << FBPI;
 }
 
+// serve the lists of the collection from the rlz compressed list files and
+// check them against the uncompressed index. the collection has to be
+// written with t_doc_list and t_freq_list.
+template<class t_idx_type,class t_doc_list,class t_freq_list>
+void serve_lists(utils::cmdargs& args,invidx_collection& col,std::string name) {
+    auto store_docs = typename t_idx_type::builder{}
+                            .set_threads(args.threads)
+                            .set_dict_size(args.dict_size_in_bytes)
+                            .build_or_load(col,col.docs_file,"D-"+name);
+    auto store_freqs = typename t_idx_type::builder{}
+                   .set_threads(args.threads)
+                   .set_dict_size(args.dict_size_in_bytes)
+                   .build_or_load(col,col.freqs_file,"F-"+name);
+    rlz_postings_index<t_idx_type,t_doc_list,t_freq_list> postings(col,store_docs,store_freqs,name);
+
+    inverted_index<t_doc_list,t_freq_list> invidx;
+    invidx.read(col.path);
+    auto& expected = list_scratch::get(1);
+    size_t errors = 0;
+    for (size_t i = 0; i < postings.num_lists(); i++) {
+        invidx.decode_into(i, expected);
+        if (postings[i] != expected) errors++;
+    }
+    if (errors) {
+        LOG(ERROR) << name << ": " << errors << " lists served from rlz differ from the index";
+        return;
+    }
+
+    auto start = hrclock::now();
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < postings.num_lists(); i++) {
+        const auto& ld = postings[i];
+        if (ld.list_len) checksum += ld.doc_ids[ld.list_len - 1] + ld.freqs[ld.list_len - 1];
+    }
+    auto stop = hrclock::now();
+    auto secs = duration_cast<duration<double>>(stop - start).count();
+    LOG(INFO) << name << ": served " << postings.num_lists() << " lists in " << secs << " sec"
+        << " (" << col.m_meta_data.m_num_postings / secs / 1000000 << " M postings/s)"
+        << " checksum = " << checksum;
+}
+
 
 int main(int argc, const char* argv[])
 {
@@ -68,6 +111,20 @@ int main(int argc, const char* argv[])
         using factor_coder = factor_coder_blocked<3, coder::zstd<9>, coder::zstd<9>, coder::zstd<9> >;
         using idx_type = rlz_store<dict_type,block_size,factor_coder>;
         compress<block_size,idx_type>(args,col,"RLZ-ZSTD-9");
+        serve_lists<idx_type,list_u32<true>,list_u32<false>>(args,col,"RLZ-ZSTD-9");
+    }
+
+    {
+        using factor_coder = factor_coder_blocked<3, coder::zstd<9>, coder::zstd<9>, coder::zstd<9> >;
+        using idx_type = rlz_store<dict_type,block_size,factor_coder,dict_index_csa<>>;
+        compress<block_size,idx_type>(args,col,"RLZ-CSA-ZSTD-9");
+    }
+
+    {
+        using factor_coder = factor_coder_blocked<3, coder::zstd<9>, coder::zstd<9>, coder::zstd<9> >;
+        using idx_type = rlz_store<dict_type,block_size,factor_coder,dict_index_sa,factor_parse_optimal>;
+        compress<block_size,idx_type>(args,col,"RLZ-OPT-ZSTD-9");
+        serve_lists<idx_type,list_u32<true>,list_u32<false>>(args,col,"RLZ-OPT-ZSTD-9");
     }
 
 
@@ -3,15 +3,35 @@
 #include "bit_streams.hpp"
 #include "bit_coders.hpp"
 #include <functional>
+#include <numeric>
 #include <random>
+#include <thread>
 
 
 #include "utils.hpp"
+#include "d2si_reader.hpp"
 #include "list_interp.hpp"
 #include "list_interp_block.hpp"
 #include "list_vbyte_lz.hpp"
 #include "list_op4.hpp"
 #include "list_qmx.hpp"
+#include "list_simd.hpp"
+#include "list_ef.hpp"
+#include "list_pef.hpp"
+#include "list_adaptive.hpp"
+#include "list_rans.hpp"
+#include "list_vbyte_zdict.hpp"
+#include "list_rlz.hpp"
+#include "dict_index_sa.hpp"
+#include "dict_index_csa.hpp"
+#include "factor_selector.hpp"
+#include "factor_parser.hpp"
+#include "factor_coder.hpp"
+#include "list_skip.hpp"
+#include "query_and.hpp"
+#include "query_topk.hpp"
+#include "storage_index.hpp"
+#include "interleaved_storage_index.hpp"
 
 #include "logging.hpp"
 INITIALIZE_EASYLOGGINGPP
@@ -105,6 +125,42 @@ void test_compressor_u8_as_32()
 }
 
 
+// one coder object shared by several threads, each encoding and decoding
+// lists of many sizes
+template <class t_compressor>
+void test_compressor_threads()
+{
+	const t_compressor c;
+	std::vector<size_t> errors(4, 0);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < errors.size(); t++) {
+		threads.emplace_back([&c, &errors, t]() {
+			std::mt19937							gen(t);
+			std::geometric_distribution<uint32_t>	dis(0.05);
+			std::uniform_int_distribution<uint64_t> ldis(1, 20000);
+			for (size_t i = 0; i < 50; i++) {
+				std::vector<uint32_t> A(ldis(gen));
+				for (auto& x : A)
+					x = dis(gen);
+				sdsl::bit_vector bv;
+				{
+					bit_ostream<sdsl::bit_vector> os(bv);
+					c.encode(os, A.data(), A.size());
+				}
+				std::vector<uint32_t> B(1024 + A.size());
+				bit_istream<sdsl::bit_vector> is(bv);
+				c.decode(is, B.data(), A.size());
+				if (!std::equal(A.begin(), A.end(), B.begin())) errors[t]++;
+			}
+		});
+	}
+	for (auto& th : threads)
+		th.join();
+	for (auto e : errors) {
+		ASSERT_EQ(e, 0ULL);
+	}
+}
+
 TEST(bit_stream, simple16)
 {
 	test_compressor_u8_as_32<coder::simple16>();
@@ -219,6 +275,49 @@ TEST(list_interp, increasing2)
 }
 
 
+TEST(list_interp, range)
+{
+	// sparse stretches and dense runs so both decoding paths are hit
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint32_t> gap_dis(1, 5000);
+	std::uniform_int_distribution<uint32_t> len_dis(1, 300);
+	for (size_t k = 0; k < 20; k++) {
+		std::vector<uint32_t> C;
+		uint32_t			  cur = 0;
+		for (size_t i = 0; i < 50; i++) {
+			cur += gap_dis(gen);
+			size_t len  = len_dis(gen);
+			bool   full = i % 2 == 0;
+			for (size_t j = 0; j < len; j++) {
+				C.push_back(cur);
+				cur += full ? 1 : gap_dis(gen) % 50 + 1;
+			}
+		}
+		size_t				  n = C.size();
+		std::vector<uint32_t> A(C);
+		sdsl::bit_vector	  bv;
+		{
+			bit_ostream<sdsl::bit_vector> os(bv);
+			list_interp<false>::encode(os, A, n, cur);
+		}
+		std::uniform_int_distribution<uint32_t> pos_dis(0, cur);
+		for (size_t q = 0; q < 50; q++) {
+			uint32_t lo = pos_dis(gen);
+			uint32_t hi = q % 5 == 0 ? lo : pos_dis(gen);
+			if (hi < lo) std::swap(lo, hi);
+			auto				  begin = std::lower_bound(C.begin(), C.end(), lo);
+			auto				  end   = std::upper_bound(C.begin(), C.end(), hi);
+			std::vector<uint32_t> B(n);
+			bit_istream<sdsl::bit_vector> is(bv);
+			size_t found = list_interp<false>::decode_range(is, B, n, cur, lo, hi);
+			ASSERT_EQ(found, size_t(std::distance(begin, end)));
+			for (size_t i = 0; i < found; i++) {
+				ASSERT_EQ(B[i], *(begin + i));
+			}
+		}
+	}
+}
+
 TEST(list_interp, prefixsum)
 {
 	size_t									n = 20;
@@ -431,6 +530,45 @@ TEST(bit_stream, gamma)
 }
 
 
+TEST(bit_stream, elias_fano)
+{
+	// sequences of every low width, written back to back after a stray bit
+	// so they start at arbitrary offsets and the last one ends the stream
+	std::mt19937					   gen(4711);
+	std::vector<std::vector<uint32_t>> seqs;
+	std::vector<uint64_t>			   universes;
+	for (uint64_t u = 2; u < (uint64_t(1) << 32); u = u * 3 / 2 + 1) {
+		std::uniform_int_distribution<uint64_t> dis(0, u - 1);
+		std::uniform_int_distribution<size_t>   len_dis(1, std::min(u, uint64_t(2000)));
+		std::vector<uint32_t>					A(len_dis(gen));
+		for (auto& x : A)
+			x = dis(gen);
+		std::sort(A.begin(), A.end());
+		seqs.push_back(A);
+		universes.push_back(u);
+	}
+	coder::elias_fano c;
+	sdsl::bit_vector  bv;
+	{
+		bit_ostream<sdsl::bit_vector> os(bv);
+		for (size_t i = 0; i < seqs.size(); i++) {
+			os.put_int(1, 1);
+			c.encode(os, seqs[i].data(), seqs[i].size(), universes[i]);
+		}
+	}
+	bit_istream<sdsl::bit_vector> is(bv);
+	for (size_t i = 0; i < seqs.size(); i++) {
+		ASSERT_EQ(is.get_int(1), 1ULL);
+		std::vector<uint32_t> B(seqs[i].size());
+		c.decode(is, B.data(), B.size(), universes[i]);
+		for (size_t j = 0; j < B.size(); j++) {
+			ASSERT_EQ(B[j], seqs[i][j]);
+		}
+	}
+	ASSERT_TRUE(is.eof());
+}
+
+
 TEST(bit_stream, vbyte)
 {
 	size_t									n = 20;
@@ -594,6 +732,111 @@ TEST(bit_stream, zstd)
 	test_compressor_u32<coder::zstd<6>>();
 }
 
+TEST(bit_stream, threads)
+{
+	test_compressor_threads<coder::zstd<9>>();
+	test_compressor_threads<coder::lzma<6>>();
+	test_compressor_threads<coder::bzip2<9>>();
+	test_compressor_threads<coder::zlib<9>>();
+}
+
+TEST(bit_stream, rans)
+{
+	test_compressor_u32<coder::rans>();
+	// geometric, single symbol, empty and full width sequences back to back
+	// after a stray bit so they start at arbitrary offsets
+	std::mt19937					   gen(4711);
+	std::geometric_distribution<uint32_t> geo_dis(0.05);
+	std::uniform_int_distribution<uint32_t> dis;
+	std::vector<std::vector<uint32_t>> seqs;
+	for (size_t n : {0, 1, 5, 100, 5000, 100000}) {
+		std::vector<uint32_t> geo(n), same(n, 7), full(n);
+		for (size_t i = 0; i < n; i++) {
+			geo[i]  = geo_dis(gen);
+			full[i] = dis(gen);
+		}
+		if (n) full[0] = std::numeric_limits<uint32_t>::max();
+		seqs.push_back(geo);
+		seqs.push_back(same);
+		seqs.push_back(full);
+	}
+	coder::rans		 c;
+	sdsl::bit_vector bv;
+	{
+		bit_ostream<sdsl::bit_vector> os(bv);
+		for (const auto& A : seqs) {
+			os.put_int(1, 1);
+			c.encode(os, A.data(), A.size());
+		}
+	}
+	bit_istream<sdsl::bit_vector> is(bv);
+	for (const auto& A : seqs) {
+		ASSERT_EQ(is.get_int(1), 1ULL);
+		std::vector<uint32_t> B(A.size());
+		c.decode(is, B.data(), B.size());
+		for (size_t i = 0; i < A.size(); i++) {
+			ASSERT_EQ(B[i], A[i]);
+		}
+	}
+	ASSERT_TRUE(is.eof());
+}
+
+TEST(utils, prefix_sum)
+{
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint32_t> dis;
+	for (size_t n = 0; n < 100; n++) {
+		std::vector<uint32_t> A(n);
+		for (auto& x : A)
+			x = dis(gen);
+		uint32_t			  base = dis(gen);
+		std::vector<uint32_t> expected(A);
+		uint32_t			  sum = base;
+		for (auto& x : expected) {
+			sum += x;
+			x = sum;
+		}
+		std::vector<uint32_t> B(A);
+		ASSERT_EQ(utils::prefix_sum(B.data(), n, base), sum);
+		ASSERT_TRUE(B == expected);
+		utils::adjacent_difference(B.data(), n, base);
+		ASSERT_TRUE(B == A);
+		std::vector<uint32_t> C(n);
+		ASSERT_EQ(utils::prefix_sum(A.data(), C.data(), n, base), sum);
+		ASSERT_TRUE(C == expected);
+	}
+}
+
+TEST(vbyte_fastpfor, decode_dgap)
+{
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint32_t> dis;
+	coder::vbyte_fastpfor					vcoder;
+	for (size_t n = 0; n < 1000; n += 7) {
+		std::vector<uint32_t> A(n);
+		// gaps of all encoded lengths
+		for (auto& x : A)
+			x = dis(gen) >> (dis(gen) % 32);
+		sdsl::bit_vector bv;
+		{
+			bit_ostream<sdsl::bit_vector> os(bv);
+			vcoder.encode(os, A.data(), n);
+			os.put_int(4711, 32);
+		}
+		uint32_t			  sum = 17;
+		std::vector<uint32_t> expected(A);
+		for (auto& x : expected) {
+			sum += x;
+			x = sum;
+		}
+		std::vector<uint32_t>		  B(n);
+		bit_istream<sdsl::bit_vector> is(bv);
+		ASSERT_EQ(vcoder.decode_dgap(is, B.data(), n, 17), sum);
+		ASSERT_TRUE(B == expected);
+		ASSERT_EQ(is.get_int(32), 4711ULL);
+	}
+}
+
 template <class t_list>
 void test_list_increasing()
 {
@@ -668,6 +911,478 @@ TEST(list_qmx, increasing) { test_list_increasing<list_qmx<true>>(); }
 
 TEST(list_qmx, unordered) { test_list_unordered<list_qmx<false>>(); }
 
+// lists followed by more data are decoded in place, the last list of a
+// stream from a copy
+template <class t_list>
+void test_list_stream()
+{
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint64_t> ldis(1, 5000);
+	std::uniform_int_distribution<uint64_t> dis(1, 100000);
+	std::vector<std::vector<uint32_t>>		lists(50);
+	for (auto& l : lists) {
+		l.resize(ldis(gen));
+		for (auto& x : l)
+			x = dis(gen);
+	}
+	sdsl::bit_vector bv;
+	{
+		bit_ostream<sdsl::bit_vector> os(bv);
+		for (const auto& l : lists) {
+			std::vector<uint32_t> A(l);
+			A.resize(l.size() + 1024);
+			t_list::encode(os, A, l.size(), 100000);
+		}
+	}
+	bit_istream<sdsl::bit_vector> is(bv);
+	for (const auto& l : lists) {
+		std::vector<uint32_t> B(l.size() + 1024);
+		t_list::decode(is, B, l.size(), 100000);
+		for (size_t i = 0; i < l.size(); i++) {
+			ASSERT_EQ(B[i], l[i]);
+		}
+	}
+}
+
+TEST(list_simd, increasing)
+{
+	test_list_increasing<list_simdbp128<true>>();
+	test_list_increasing<list_simdfastpfor<true>>();
+	test_list_increasing<list_streamvbyte<true>>();
+	test_list_increasing<list_maskedvbyte<true>>();
+	test_list_increasing<list_varintg8iu<true>>();
+}
+
+TEST(list_simd, unordered)
+{
+	test_list_unordered<list_simdbp128<false>>();
+	test_list_unordered<list_simdfastpfor<false>>();
+	test_list_unordered<list_streamvbyte<false>>();
+	test_list_unordered<list_maskedvbyte<false>>();
+	test_list_unordered<list_varintg8iu<false>>();
+}
+
+TEST(list_simd, stream)
+{
+	test_list_stream<list_simdbp128<false>>();
+	test_list_stream<list_simdfastpfor<false>>();
+	test_list_stream<list_streamvbyte<false>>();
+	test_list_stream<list_maskedvbyte<false>>();
+	test_list_stream<list_varintg8iu<false>>();
+}
+
+TEST(list_pef, increasing) { test_list_increasing<list_pef<false>>(); }
+
+TEST(list_pef, unordered) { test_list_unordered<list_pef<true>>(); }
+
+TEST(list_pef, clustered)
+{
+	// dense runs and sparse gaps so runs, bitmaps and ef partitions are mixed
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint32_t> gap_dis(1, 100000);
+	std::uniform_int_distribution<uint32_t> len_dis(1, 2000);
+	std::uniform_int_distribution<uint32_t> step_dis(1, 3);
+	std::vector<uint32_t>					C;
+	uint32_t								cur = 0;
+	for (size_t i = 0; i < 200; i++) {
+		cur += gap_dis(gen);
+		size_t len  = len_dis(gen);
+		bool   full = i % 3 == 0;
+		for (size_t j = 0; j < len; j++) {
+			C.push_back(cur);
+			cur += full ? 1 : step_dis(gen);
+		}
+	}
+	std::vector<uint32_t> A(C);
+	A.resize(C.size() + 1024);
+	auto ends = pef::optimal_partition(A.data(), C.size());
+	ASSERT_GT(ends.size(), 1ULL);
+	sdsl::bit_vector bv;
+	{
+		bit_ostream<sdsl::bit_vector> os(bv);
+		list_pef<false>::encode(os, A, C.size(), cur);
+		list_pef<false>::encode(os, A, C.size(), cur);
+	}
+	bit_istream<sdsl::bit_vector> is(bv);
+	for (size_t k = 0; k < 2; k++) {
+		std::vector<uint32_t> B(C.size() + 1024);
+		list_pef<false>::decode(is, B, C.size(), cur);
+		for (size_t i = 0; i < C.size(); i++) {
+			ASSERT_EQ(B[i], C[i]);
+		}
+	}
+	ASSERT_TRUE(is.eof());
+}
+
+TEST(list_rans, increasing) { test_list_increasing<list_rans<true, 128>>(); }
+
+TEST(list_rans, unordered) { test_list_unordered<list_rans<false, 128>>(); }
+
+TEST(list_adaptive, increasing) { test_list_increasing<list_adaptive<true>>(); }
+
+TEST(list_adaptive, unordered) { test_list_unordered<list_adaptive<false>>(); }
+
+template <uint32_t t_lambda>
+uint64_t adaptive_encoded_size(const std::vector<std::vector<uint32_t>>& lists, uint32_t universe)
+{
+	using list_type = list_adaptive<true, t_lambda>;
+	sdsl::bit_vector bv;
+	{
+		bit_ostream<sdsl::bit_vector> os(bv);
+		for (const auto& l : lists) {
+			std::vector<uint32_t> A(l);
+			A.resize(l.size() + 1024);
+			list_type::encode(os, A, l.size(), universe);
+		}
+	}
+	bit_istream<sdsl::bit_vector> is(bv);
+	for (const auto& l : lists) {
+		std::vector<uint32_t> B(l.size() + 1024);
+		list_type::decode(is, B, l.size(), universe);
+		for (size_t i = 0; i < l.size(); i++) {
+			EXPECT_EQ(B[i], l[i]);
+		}
+	}
+	return bv.size();
+}
+
+TEST(list_adaptive, lambda)
+{
+	// lists of very different density so the candidates take turns winning.
+	// a larger lambda can only cost space.
+	std::mt19937						   gen(4711);
+	std::vector<std::vector<uint32_t>>	 lists;
+	for (uint32_t max_gap : {1, 2, 10, 1000, 100000}) {
+		std::uniform_int_distribution<uint32_t> gap_dis(1, max_gap);
+		std::uniform_int_distribution<size_t>   len_dis(1, 3000);
+		for (size_t i = 0; i < 10; i++) {
+			std::vector<uint32_t> l(len_dis(gen));
+			uint32_t			  cur = 0;
+			for (auto& x : l) {
+				cur += gap_dis(gen);
+				x = cur;
+			}
+			lists.push_back(l);
+		}
+	}
+	const uint32_t universe = 400000000;
+	auto		   size0	= adaptive_encoded_size<0>(lists, universe);
+	auto		   size1	= adaptive_encoded_size<1>(lists, universe);
+	auto		   size1000 = adaptive_encoded_size<1000>(lists, universe);
+	ASSERT_LE(size0, size1);
+	ASSERT_LE(size1, size1000);
+	ASSERT_EQ(list_adaptive<true>::name(), "adaptive-l0");
+	ASSERT_EQ((list_adaptive<true, 1000>::name()), "adaptive-l1000");
+}
+
+TEST(list_skip, increasing)
+{
+	test_list_increasing<list_skip<list_op4<128, true>>>();
+	test_list_increasing<list_skip<list_qmx<true>>>();
+	test_list_increasing<list_skip<list_interp_block<128, false>>>();
+	test_list_increasing<list_skip<list_ef<false>>>();
+}
+
+TEST(list_skip_freqs, unordered)
+{
+	test_list_unordered<list_skip_freqs<list_op4<128, false>>>();
+	test_list_unordered<list_skip_freqs<list_qmx<false>>>();
+	test_list_unordered<list_skip_freqs<list_interp_block<128, true>>>();
+}
+
+template <class t_doc_list, class t_freq_list = list_op4<128, false>>
+void test_cursor_next_geq()
+{
+	using freq_list_type = t_freq_list;
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint64_t> dis(1, 1000000);
+	std::uniform_int_distribution<uint64_t> fdis(1, 16);
+
+	for (size_t i = 0; i < 10; i++) {
+		size_t				  len = dis(gen) / 10;
+		std::vector<uint32_t> A(len + 1024);
+		for (size_t j = 0; j < len; j++)
+			A[j] = dis(gen);
+		std::sort(A.begin(), A.begin() + len);
+		auto				  list_len = std::distance(A.begin(), std::unique(A.begin(), A.begin() + len));
+		std::vector<uint32_t> C(A.begin(), A.begin() + list_len);
+		std::vector<uint32_t> F(list_len + 1024);
+		list_meta_data		  lm;
+		lm.list_len = list_len;
+		for (auto j = 0; j < list_len; j++) {
+			F[j] = fdis(gen);
+			lm.Ft += F[j];
+		}
+		std::vector<uint32_t> G(F.begin(), F.begin() + list_len);
+		sdsl::bit_vector	  docs, freqs;
+		{
+			bit_ostream<sdsl::bit_vector> os(docs);
+			t_doc_list::encode(os, A, list_len, 1000000);
+		}
+		{
+			bit_ostream<sdsl::bit_vector> os(freqs);
+			freq_list_type::encode(os, F, list_len, lm.Ft);
+		}
+		bit_view docs_view(docs), freqs_view(freqs);
+
+		list_cursor<t_doc_list, freq_list_type> itr(docs_view, freqs_view, lm, 1000000);
+		uint32_t target = 0;
+		while (target <= 1000000) {
+			itr.next_geq(target);
+			auto pos = std::lower_bound(C.begin(), C.end(), target) - C.begin();
+			if (pos == list_len) {
+				ASSERT_EQ(itr.docid(), itr.end_docid);
+				break;
+			}
+			ASSERT_EQ(itr.docid(), C[pos]);
+			ASSERT_EQ(itr.position(), size_t(pos));
+			ASSERT_EQ(itr.freq(), G[pos]);
+			target += dis(gen) % 5000;
+		}
+	}
+}
+
+TEST(list_cursor, next_geq)
+{
+	test_cursor_next_geq<list_op4<128, true>>();
+	test_cursor_next_geq<list_skip<list_op4<128, true>>>();
+	test_cursor_next_geq<list_skip<list_qmx<true>>>();
+	test_cursor_next_geq<list_skip<list_interp_block<128, false>>>();
+	test_cursor_next_geq<list_skip<list_ef<false>>>();
+	test_cursor_next_geq<list_pef<false>>();
+	// freqs decoded block by block
+	test_cursor_next_geq<list_skip<list_op4<128, true>>, list_skip_freqs<list_op4<128, false>>>();
+	test_cursor_next_geq<list_skip<list_qmx<true>>, list_skip_freqs<list_qmx<false>>>();
+	test_cursor_next_geq<list_pef<false>, list_skip_freqs<list_interp_block<128, true>, 256>>();
+}
+
+template <class t_intersect>
+void test_intersect()
+{
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint64_t> len_dis(0, 100000);
+	for (size_t i = 0; i < 20; i++) {
+		// vary the density so both balanced and skewed inputs are covered
+		std::uniform_int_distribution<uint32_t> dis(0, 1000 + len_dis(gen) * 10);
+		std::vector<uint32_t>					A(len_dis(gen) / (i % 3 ? 1 : 50));
+		std::vector<uint32_t>					B(len_dis(gen));
+		for (auto& x : A)
+			x = dis(gen);
+		for (auto& x : B)
+			x = dis(gen);
+		std::sort(A.begin(), A.end());
+		A.erase(std::unique(A.begin(), A.end()), A.end());
+		std::sort(B.begin(), B.end());
+		B.erase(std::unique(B.begin(), B.end()), B.end());
+		std::vector<uint32_t> expected;
+		std::set_intersection(A.begin(), A.end(), B.begin(), B.end(), std::back_inserter(expected));
+		std::vector<uint32_t> out(std::min(A.size(), B.size()) + 8);
+		size_t n = t_intersect::apply(A.data(), A.size(), B.data(), B.size(), out.data());
+		ASSERT_EQ(n, expected.size());
+		for (size_t j = 0; j < n; j++) {
+			ASSERT_EQ(out[j], expected[j]);
+		}
+	}
+}
+
+TEST(intersect, kernels)
+{
+	test_intersect<intersect::merge>();
+	test_intersect<intersect::galloping>();
+	test_intersect<intersect::simd_sse>();
+	if (intersect::simd_avx2::supported()) test_intersect<intersect::simd_avx2>();
+	test_intersect<intersect::adaptive<intersect::simd_sse>>();
+}
+
+// small random collection in d2si format with zipf-ish list lengths
+void write_d2si(std::string prefix, uint32_t num_docs, size_t num_lists)
+{
+	std::mt19937						gen(4711);
+	std::uniform_int_distribution<uint32_t> doc_dis(0, num_docs - 1);
+	std::uniform_int_distribution<uint32_t> freq_dis(1, 20);
+	std::ofstream						docs(prefix + ".docs", std::ios::binary);
+	std::ofstream						freqs(prefix + ".freqs", std::ios::binary);
+	auto write_u32 = [](std::ofstream& out, uint32_t x) { out.write((const char*)&x, sizeof(x)); };
+	write_u32(docs, 1);
+	write_u32(docs, num_docs);
+	for (size_t i = 0; i < num_lists; i++) {
+		std::vector<uint32_t> ids(1 + num_docs / (i + 1));
+		for (auto& x : ids)
+			x = doc_dis(gen);
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		write_u32(docs, ids.size());
+		write_u32(freqs, ids.size());
+		for (auto x : ids) {
+			write_u32(docs, x);
+			write_u32(freqs, freq_dis(gen));
+		}
+	}
+}
+
+TEST(query_topk, pruning_matches_exhaustive)
+{
+	std::string prefix = "/tmp/unit-tests-d2si-" + std::to_string(getpid());
+	write_d2si(prefix, 50000, 200);
+	inverted_index<list_skip<list_op4<128, true>>, list_skip_freqs<list_op4<128, false>>> index(prefix);
+	ASSERT_TRUE(index.verify(prefix));
+
+	std::mt19937						  gen(4711);
+	std::uniform_int_distribution<size_t> term_dis(0, index.num_lists() - 1);
+	std::vector<doc_score>				  expected, wand, bmw, maxscore;
+	for (size_t i = 0; i < 200; i++) {
+		std::vector<uint64_t> terms;
+		for (size_t j = 0; j < 2 + i % 4; j++)
+			terms.push_back(term_dis(gen));
+		topk_query_or(index, terms, 10, expected);
+		topk_query_wand(index, terms, 10, wand);
+		topk_query_bmw(index, terms, 10, bmw);
+		topk_query_maxscore(index, terms, 10, maxscore);
+		ASSERT_EQ(expected.size(), wand.size());
+		ASSERT_EQ(expected.size(), bmw.size());
+		ASSERT_EQ(expected.size(), maxscore.size());
+		for (size_t j = 0; j < expected.size(); j++) {
+			ASSERT_NEAR(expected[j].score, wand[j].score, 1e-6);
+			ASSERT_NEAR(expected[j].score, bmw[j].score, 1e-6);
+			ASSERT_NEAR(expected[j].score, maxscore[j].score, 1e-6);
+		}
+	}
+	std::remove((prefix + ".docs").c_str());
+	std::remove((prefix + ".freqs").c_str());
+}
+
+TEST(inverted_index, parallel_build)
+{
+	// enough postings for several batches so the encoded streams get stitched
+	std::string prefix = "/tmp/unit-tests-d2si-" + std::to_string(getpid());
+	write_d2si(prefix, 1000000, 20);
+	using invidx_type = inverted_index<list_qmx<true>, list_ef<true>>;
+	invidx_type serial(prefix, 1);
+	invidx_type parallel(prefix, 4);
+	ASSERT_TRUE(parallel.verify(prefix));
+	ASSERT_EQ(serial.num_lists(), parallel.num_lists());
+	list_data a, b;
+	for (size_t i = 0; i < serial.num_lists(); i++) {
+		ASSERT_EQ(serial.max_score(i), parallel.max_score(i));
+		serial.decode_into(i, a);
+		parallel.decode_into(i, b);
+		ASSERT_FALSE(a != b);
+	}
+	std::remove((prefix + ".docs").c_str());
+	std::remove((prefix + ".freqs").c_str());
+}
+
+TEST(inverted_index, dictionaries)
+{
+	// every index owns its list dictionaries, building or reading another
+	// index of the same type leaves them alone
+	std::string prefix	= "/tmp/unit-tests-d2si-" + std::to_string(getpid());
+	std::string prefix2 = prefix + "-2";
+	std::string dir		= prefix + "-idx";
+	write_d2si(prefix, 50000, 100);
+	write_d2si(prefix2, 20000, 100);
+	using invidx_type = inverted_index<list_vbyte_zdict<true, 16, 9>, list_rlz<false, 128>>;
+	invidx_type first(prefix, 2);
+	first.write(dir);
+	invidx_type second(prefix2, 2);
+	ASSERT_TRUE(first.verify(prefix));
+	invidx_type loaded;
+	loaded.read(dir);
+	invidx_type mapped;
+	mapped.read_mapped(dir);
+	ASSERT_TRUE(second.verify(prefix2));
+	ASSERT_TRUE(loaded.verify(prefix));
+	ASSERT_TRUE(mapped.verify(prefix));
+	for (auto p : {prefix, prefix2}) {
+		std::remove((p + ".docs").c_str());
+		std::remove((p + ".freqs").c_str());
+	}
+	for (auto f : {DOCS_NAME, FREQS_NAME, META_NAME, DOCLENS_NAME, BLOCKMAX_NAME})
+		std::remove((dir + "/" + f).c_str());
+	rmdir(dir.c_str());
+}
+
+TEST(d2si_reader, lists)
+{
+	std::string prefix = "/tmp/unit-tests-d2si-" + std::to_string(getpid());
+	write_d2si(prefix, 1000, 10);
+	{
+		d2si_reader input(prefix);
+		ASSERT_EQ(input.num_docs(), 1000ULL);
+		ASSERT_EQ(input.num_lists(), 10ULL);
+		size_t num_postings = 0;
+		auto   freq_itr		= input.freqs().begin();
+		for (const auto& docs : input.docs()) {
+			ASSERT_EQ(docs.size(), (*freq_itr).size());
+			for (size_t i = 1; i < docs.size(); i++)
+				ASSERT_LT(docs[i - 1], docs[i]);
+			num_postings += docs.size();
+			++freq_itr;
+		}
+		ASSERT_TRUE(freq_itr == input.freqs().end());
+		ASSERT_EQ(num_postings, input.num_postings());
+	}
+	{
+		// move a freq from the first list to the second, the totals still match
+		std::vector<uint32_t> freqs(utils::file_size(prefix + ".freqs") / sizeof(uint32_t));
+		std::ifstream(prefix + ".freqs", std::ios::binary).read((char*)freqs.data(), freqs.size() * sizeof(uint32_t));
+		auto second = freqs.begin() + 1 + freqs[0];
+		std::rotate(second - 1, second, second + 1);
+		freqs[0]--;
+		freqs[freqs[0] + 1]++;
+		std::ofstream(prefix + ".freqs", std::ios::binary).write((const char*)freqs.data(), freqs.size() * sizeof(uint32_t));
+		ASSERT_THROW(d2si_reader input(prefix), std::runtime_error);
+	}
+	// cut off the last posting
+	auto size = utils::file_size(prefix + ".freqs");
+	ASSERT_EQ(truncate((prefix + ".freqs").c_str(), size - sizeof(uint32_t)), 0);
+	ASSERT_THROW(d2si_reader input(prefix), std::runtime_error);
+	std::remove((prefix + ".docs").c_str());
+	std::remove((prefix + ".freqs").c_str());
+}
+
+TEST(storage_index, chunked)
+{
+	// a small budget splits the stream into many frames
+	std::string prefix = "/tmp/unit-tests-d2si-" + std::to_string(getpid());
+	write_d2si(prefix, 20000, 20);
+	uint64_t budget = 1024 * storage_chunks::bytes_per_int;
+	// frames grow with the budget unless capped
+	ASSERT_EQ(storage_chunks::frame_size(64 * budget), 64 * 1024ULL);
+	ASSERT_EQ(storage_chunks::frame_size(64 * budget, 4096), 4096ULL);
+	storage_index<coder::vbyte_fastpfor, coder::zstd<9>> idx(prefix, budget);
+	ASSERT_GT(idx.m_doc_frames.size(), 1ULL);
+	ASSERT_TRUE(idx.verify(prefix));
+	interleaved_storage_index<coder::simple16, coder::zstd<9>> iidx(prefix, budget);
+	ASSERT_GT(iidx.m_frames.size(), 1ULL);
+	ASSERT_TRUE(iidx.verify(prefix));
+
+	// single lists in random order decode only the frames they span
+	d2si_reader			   input(prefix);
+	std::vector<d2si_list> docs, freqs;
+	for (const auto& l : input.docs())
+		docs.push_back(l);
+	for (const auto& l : input.freqs())
+		freqs.push_back(l);
+	std::vector<size_t> order(docs.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::shuffle(order.begin(), order.end(), std::mt19937(4711));
+	list_data ld, ild;
+	for (auto i : order) {
+		idx.decode_into(i, ld);
+		iidx.decode_into(i, ild);
+		ASSERT_EQ(ld.list_len, docs[i].size());
+		ASSERT_EQ(ild.list_len, docs[i].size());
+		for (size_t j = 0; j < docs[i].size(); j++) {
+			ASSERT_EQ(ld.doc_ids[j], docs[i][j]);
+			ASSERT_EQ(ld.freqs[j], freqs[i][j]);
+			ASSERT_EQ(ild.doc_ids[j], docs[i][j]);
+			ASSERT_EQ(ild.freqs[j], freqs[i][j]);
+		}
+	}
+	std::remove((prefix + ".docs").c_str());
+	std::remove((prefix + ".freqs").c_str());
+}
 
 TEST(list_vbyte_lz, increasing)
 {
@@ -773,6 +1488,347 @@ TEST(list_vbyte_lz, prefixsum)
 }
 
 
+TEST(list_vbyte_lz, threads)
+{
+	// lists of very different lengths decoded by several threads at once,
+	// every thread has to use its own scratch space and coder state
+	std::mt19937						   gen(4711);
+	std::uniform_int_distribution<uint32_t> gap_dis(1, 100);
+	std::vector<std::vector<uint32_t>>	 lists;
+	for (size_t len : {10, 200, 5000, 100000, 1000000, 300, 20000}) {
+		std::vector<uint32_t> l(len);
+		uint32_t			  cur = 0;
+		for (auto& x : l) {
+			cur += gap_dis(gen);
+			x = cur;
+		}
+		lists.push_back(l);
+	}
+	using list_type = list_vbyte_lz<true, 128, coder::zstd<9>>;
+	sdsl::bit_vector	bv;
+	std::vector<size_t> offsets;
+	{
+		bit_ostream<sdsl::bit_vector> os(bv);
+		for (const auto& l : lists) {
+			offsets.push_back(os.tellp());
+			std::vector<uint32_t> A(l);
+			A.resize(l.size() + 1024);
+			list_type::encode(os, A, l.size(), l.back());
+		}
+	}
+	std::vector<size_t>		 errors(4, 0);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < errors.size(); t++) {
+		threads.emplace_back([&, t]() {
+			bit_istream<sdsl::bit_vector> is(bv);
+			std::vector<uint32_t>		  B;
+			for (size_t r = 0; r < 5; r++) {
+				for (size_t k = 0; k < lists.size(); k++) {
+					size_t i = (k + t) % lists.size();
+					B.assign(lists[i].size() + 1024, 0);
+					is.seek(offsets[i]);
+					list_type::decode(is, B, lists[i].size(), lists[i].back());
+					if (!std::equal(lists[i].begin(), lists[i].end(), B.begin())) errors[t]++;
+				}
+			}
+		});
+	}
+	for (auto& th : threads)
+		th.join();
+	for (auto e : errors) {
+		ASSERT_EQ(e, 0ULL);
+	}
+}
+
+TEST(list_vbyte_zdict, dictionary)
+{
+	// many short lists sharing their gap distribution. the dictionary is
+	// trained on them, stored and read back into a new state before decoding.
+	using list_type = list_vbyte_zdict<true, 16, 9>;
+	std::mt19937						   gen(4711);
+	std::geometric_distribution<uint32_t>  gap_dis(0.01);
+	std::uniform_int_distribution<size_t>  len_dis(1, 2000);
+	std::vector<std::vector<uint32_t>>	 lists(2000);
+	for (auto& l : lists) {
+		l.resize(len_dis(gen));
+		uint32_t cur = 0;
+		for (auto& x : l) {
+			cur += gap_dis(gen) + 1;
+			x = cur;
+		}
+	}
+	list_type::dictionary_state state;
+	list_type::train_dictionary(state, lists);
+	ASSERT_FALSE(state.dict.empty());
+
+	sdsl::bit_vector bv;
+	{
+		bit_ostream<sdsl::bit_vector> os(bv);
+		list_type::write_dictionary(os, state);
+		for (const auto& l : lists) {
+			std::vector<uint32_t> A(l);
+			A.resize(l.size() + 1024);
+			list_type::encode(os, A, l.size(), l.back(), state);
+		}
+	}
+	// a dictionary trained on other lists does not affect the first one
+	list_type::dictionary_state other;
+	list_type::train_dictionary(other, std::vector<std::vector<uint32_t>>(lists.begin(), lists.begin() + lists.size() / 2));
+	list_type::dictionary_state read_state;
+	bit_istream<sdsl::bit_vector> is(bv);
+	list_type::read_dictionary(is, read_state);
+	ASSERT_TRUE(read_state.dict == state.dict);
+	for (const auto& l : lists) {
+		std::vector<uint32_t> B(l.size() + 1024);
+		list_type::decode(is, B, l.size(), l.back(), read_state);
+		for (size_t i = 0; i < l.size(); i++) {
+			ASSERT_EQ(B[i], l[i]);
+		}
+	}
+}
+
+TEST(list_vbyte_zdict, no_dictionary)
+{
+	test_list_increasing<list_vbyte_zdict<true, 16, 9>>();
+}
+
+TEST(dict_index_sa, factorize)
+{
+	// small alphabet with zeros so matches run into the end of the
+	// dictionary, plus a symbol the dictionary does not contain
+	std::mt19937						   gen(4711);
+	std::uniform_int_distribution<uint8_t> dis(0, 2);
+	sdsl::int_vector<8>					   dict(3000);
+	for (size_t i = 0; i < dict.size(); i++)
+		dict[i] = dis(gen);
+	dict_index_sa		 index(dict);
+	std::vector<uint8_t> text(20000);
+	for (auto& x : text)
+		x = dis(gen);
+	for (size_t i = 0; i < text.size(); i += 997)
+		text[i] = 7;
+	std::copy(dict.end() - 50, dict.end(), text.end() - 50);
+
+	const uint8_t* begin	   = text.data();
+	auto		   factor_itr = index.factorize(begin, begin + text.size());
+	size_t		   pos		   = 0;
+	while (!factor_itr.finished()) {
+		size_t len = factor_itr.len;
+		if (len == 0) {
+			ASSERT_TRUE(std::find(dict.begin(), dict.end(), text[pos]) == dict.end());
+			pos++;
+		} else {
+			uint64_t offset = index.sa[factor_itr.sp];
+			ASSERT_LE(offset + len, dict.size());
+			ASSERT_TRUE(std::equal(text.begin() + pos, text.begin() + pos + len, dict.begin() + offset));
+			// greedy: the factor can not be extended
+			if (pos + len < text.size()) {
+				auto found = std::search(dict.begin(), dict.end(), text.begin() + pos, text.begin() + pos + len + 1);
+				ASSERT_TRUE(found == dict.end());
+			}
+			pos += len;
+		}
+		++factor_itr;
+	}
+	ASSERT_EQ(pos, text.size());
+}
+
+TEST(dict_index_csa, factorize)
+{
+	// same greedy factor lengths as the suffix array index, with the
+	// offset taken from the reversed dictionary
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint16_t> dis(0, 255);
+	sdsl::int_vector<8>						dict(3000);
+	for (size_t i = 0; i < dict.size(); i++)
+		dict[i] = dis(gen) % 3;
+	dict[100] = 0;
+	dict[101] = 255;
+	dict_index_sa		 sa_index(dict);
+	dict_index_csa<>	 csa_index(dict);
+	std::vector<uint8_t> text(20000);
+	for (auto& x : text)
+		x = dis(gen) % 3;
+	for (size_t i = 0; i < text.size(); i += 997)
+		text[i] = 7;
+	std::copy(dict.end() - 50, dict.end(), text.end() - 50);
+
+	const uint8_t* begin   = text.data();
+	auto		   sa_itr  = sa_index.factorize(begin, begin + text.size());
+	auto		   csa_itr = csa_index.factorize(begin, begin + text.size());
+	size_t		   pos	   = 0;
+	while (!sa_itr.finished()) {
+		ASSERT_FALSE(csa_itr.finished());
+		size_t len = csa_itr.len;
+		ASSERT_EQ(sa_itr.len, len);
+		if (len) {
+			uint64_t offset = factor_select_first::pick_offset(csa_index, csa_itr);
+			ASSERT_LE(offset + len, dict.size());
+			ASSERT_TRUE(std::equal(text.begin() + pos, text.begin() + pos + len, dict.begin() + offset));
+		}
+		pos += std::max(len, size_t(1));
+		++sa_itr;
+		++csa_itr;
+	}
+	ASSERT_TRUE(csa_itr.finished());
+	ASSERT_EQ(pos, text.size());
+}
+
+template <class t_parser, class t_coder>
+size_t factor_parse_bits(const dict_index_sa& index, const sdsl::int_vector<8>& dict,
+						 const std::vector<uint8_t>& text)
+{
+	t_coder			  coder;
+	block_factor_data bfd(text.size());
+	t_parser::parse(index, bfd, coder, text.data(), text.size());
+	size_t			 num_factors = bfd.num_factors;
+	sdsl::bit_vector bv;
+	size_t			 bits;
+	{
+		bit_ostream<sdsl::bit_vector> out(bv);
+		coder.encode_block(out, bfd);
+		bits = out.tellp();
+	}
+	block_factor_data dbfd(text.size());
+	bit_istream<sdsl::bit_vector> in(bv);
+	coder.decode_block(in, dbfd, num_factors);
+	std::vector<uint8_t> decoded;
+	size_t				 literals_used = 0;
+	size_t				 offsets_used  = 0;
+	for (size_t i = 0; i < num_factors; i++) {
+		size_t len = dbfd.lengths[i];
+		if (len <= coder.literal_threshold) {
+			decoded.insert(decoded.end(), dbfd.literals.begin() + literals_used,
+						   dbfd.literals.begin() + literals_used + len);
+			literals_used += len;
+		} else {
+			auto begin = dict.begin() + dbfd.offsets[offsets_used++];
+			decoded.insert(decoded.end(), begin, begin + len);
+		}
+	}
+	EXPECT_TRUE(decoded == text);
+	return bits;
+}
+
+TEST(factor_parse_optimal, fixed_coders)
+{
+	// with fixed width coders the cost model is exact, so the optimal
+	// parse can not be larger than the greedy one
+	using coder_type = factor_coder_blocked<3, coder::fixed<8>, coder::aligned_fixed<uint32_t>, coder::vbyte>;
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint16_t> dis(0, 255);
+	sdsl::int_vector<8>						dict(20000);
+	for (size_t i = 0; i < dict.size(); i++)
+		dict[i] = dis(gen) % 4;
+	dict_index_sa		 index(dict);
+	std::vector<uint8_t> text;
+	while (text.size() < 30000) {
+		size_t offset = dis(gen) * 70;
+		size_t len	= 1 + dis(gen) % 100;
+		text.insert(text.end(), dict.begin() + offset, dict.begin() + offset + len);
+		text.push_back(dis(gen));
+	}
+	auto greedy_bits  = factor_parse_bits<factor_parse_greedy, coder_type>(index, dict, text);
+	auto optimal_bits = factor_parse_bits<factor_parse_optimal, coder_type>(index, dict, text);
+	ASSERT_LT(optimal_bits, greedy_bits);
+}
+
+TEST(factor_parse_optimal, zstd_coders)
+{
+	using coder_type = factor_coder_blocked<3, coder::zstd<9>, coder::zstd<9>, coder::zstd<9>>;
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint16_t> dis(0, 255);
+	sdsl::int_vector<8>						dict(20000);
+	for (size_t i = 0; i < dict.size(); i++)
+		dict[i] = dis(gen) % 4;
+	dict_index_sa		 index(dict);
+	std::vector<uint8_t> text(30000);
+	for (auto& x : text)
+		x = dis(gen) % 5;
+	factor_parse_bits<factor_parse_optimal, coder_type>(index, dict, text);
+}
+
+TEST(dict_index_sa_u32, longest_match)
+{
+	std::mt19937							gen(4711);
+	std::uniform_int_distribution<uint32_t> dis(0, 5);
+	std::vector<uint32_t>					dict(5000);
+	for (auto& x : dict)
+		x = dis(gen);
+	dict_index_sa_u32 index(dict);
+	std::vector<uint32_t> pattern(20);
+	for (size_t i = 0; i < 1000; i++) {
+		for (auto& x : pattern)
+			x = dis(gen);
+		uint64_t offset;
+		size_t   len = index.longest_match(pattern.data(), pattern.data() + pattern.size(), offset);
+		ASSERT_TRUE(std::equal(pattern.begin(), pattern.begin() + len, dict.begin() + offset));
+		// no occurrence of a longer prefix
+		if (len < pattern.size()) {
+			auto found = std::search(dict.begin(), dict.end(), pattern.begin(), pattern.begin() + len + 1);
+			ASSERT_TRUE(found == dict.end());
+		}
+	}
+}
+
+TEST(list_rlz, dictionary)
+{
+	// lists repeating a few gap patterns, factorized against a dictionary
+	// which is stored and read back into a new state before decoding
+	using list_type = list_rlz<true, 128>;
+	std::mt19937						   gen(4711);
+	std::geometric_distribution<uint32_t>  gap_dis(0.05);
+	std::uniform_int_distribution<size_t>  len_dis(1, 3000);
+	std::vector<std::vector<uint32_t>>	 patterns(20, std::vector<uint32_t>(50));
+	for (auto& p : patterns)
+		for (auto& x : p)
+			x = gap_dis(gen) + 1;
+	std::uniform_int_distribution<size_t> pattern_dis(0, patterns.size() - 1);
+	std::vector<std::vector<uint32_t>>	lists(500);
+	for (auto& l : lists) {
+		l.resize(len_dis(gen));
+		uint32_t cur = 0;
+		for (size_t i = 0; i < l.size(); i++) {
+			cur += (i / 50) % 3 ? gap_dis(gen) + 1 : patterns[pattern_dis(gen)][i % 50];
+			l[i] = cur;
+		}
+	}
+	list_type::dictionary_state state;
+	list_type::train_dictionary(state, lists);
+	ASSERT_FALSE(state.dict.empty());
+
+	sdsl::bit_vector bv;
+	{
+		bit_ostream<sdsl::bit_vector> os(bv);
+		list_type::write_dictionary(os, state);
+		for (const auto& l : lists) {
+			std::vector<uint32_t> A(l);
+			A.resize(l.size() + 1024);
+			list_type::encode(os, A, l.size(), l.back(), state);
+		}
+	}
+	// a dictionary trained on other lists does not affect the first one
+	list_type::dictionary_state other;
+	list_type::train_dictionary(other, std::vector<std::vector<uint32_t>>(lists.begin(), lists.begin() + lists.size() / 2));
+	list_type::dictionary_state read_state;
+	bit_istream<sdsl::bit_vector> is(bv);
+	list_type::read_dictionary(is, read_state);
+	ASSERT_TRUE(read_state.dict == state.dict);
+	for (const auto& l : lists) {
+		std::vector<uint32_t> B(l.size() + 1024);
+		list_type::decode(is, B, l.size(), l.back(), read_state);
+		for (size_t i = 0; i < l.size(); i++) {
+			ASSERT_EQ(B[i], l[i]);
+		}
+	}
+}
+
+TEST(list_rlz, no_dictionary)
+{
+	test_list_increasing<list_rlz<true, 128>>();
+	test_list_unordered<list_rlz<false, 128>>();
+}
+
 int main(int argc, char* argv[])
 {
 	::testing::InitGoogleTest(&argc, argv);